@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./init.h"
+#include "./aggregator.h"
+#include "./report.h"
+
+
+void aggregator(MPI_Comm commWorld, MPI_Comm comm) {
+	/**
+	 * Collects the reports of the nodes in this aggregator's region and forwards them to the base station in batches, 
+	 * sending a batch once it is full or no more reports are waiting
+	 * 
+	 * commWorld: communication for entire program, to enable communication with base station
+	 * comm: communication for the aggregators
+	 */
+
+	int i, index, size, completedCount, terminated = 0, terminationBuffer, regionSize, doneCount = 0;
+	int baseRank = 0;
+	long counts[2] = {0, 0}, totalCounts[2];
+
+	// Let the base station measure this rank's clock offset, and gather the addresses of the nodes
+	NodeAddress address;
+	synchronizeClocks(commWorld);
+	gatherAddresses(commWorld, &address);
+
+	// The nodes of the region are the other ranks of its communicator, a finite run of a region without any is done already
+	MPI_Comm_size(reportComm, &regionSize);
+	regionSize--;
+	if (finiteRun && regionSize == 0) 
+		MPI_Send(NULL, 0, MPI_BYTE, baseRank, REPORT_BATCH_TAG, commWorld);
+
+	// Pre-post the receives of reports from the region, and of the termination signal from the base station last
+	MPI_Request requests[AGGREGATOR_RING_SIZE + 1];
+	int completedIndices[AGGREGATOR_RING_SIZE + 1];
+	MPI_Status completedStatuses[AGGREGATOR_RING_SIZE + 1];
+	char (*ringBuffers)[REPORT_BUFFER_SIZE] = (char (*)[REPORT_BUFFER_SIZE]) malloc(AGGREGATOR_RING_SIZE * sizeof(*ringBuffers));
+
+	// Receive fixed-size reports as they are laid out, to forward their bytes unchanged
+	MPI_Datatype receiveType = reportFormat == REPORT_FIXED? ReportType: MPI_PACKED;
+	int receiveCount = reportFormat == REPORT_FIXED? 1: REPORT_BUFFER_SIZE;
+	for (i = 0; i < AGGREGATOR_RING_SIZE; i++) 
+		MPI_Irecv(ringBuffers[i], receiveCount, receiveType, MPI_ANY_SOURCE, REPORT_TAG, reportComm, &requests[i]);
+	listenForTermination(&terminationBuffer, &requests[AGGREGATOR_RING_SIZE]);
+
+	ReportBatch batch;
+	batch.size = sizeof(int);
+	batch.reportsCount = 0;
+
+	while (!terminated) {
+		// Send the batch whenever the region goes quiet, then block until more reports or the termination signal arrive, 
+		// the wait yielding the core meanwhile (mpi_yield_when_idle, set at start up)
+		MPI_Testsome(AGGREGATOR_RING_SIZE + 1, requests, &completedCount, completedIndices, completedStatuses);
+		if (completedCount == 0) {
+			if (batch.reportsCount > 0) {
+				counts[0] += batch.reportsCount;
+				counts[1]++;
+				sendBatch(commWorld, baseRank, &batch);
+			}
+			MPI_Waitsome(AGGREGATOR_RING_SIZE + 1, requests, &completedCount, completedIndices, completedStatuses);
+		}
+
+		for (i = 0; i < completedCount; i++) {
+			index = completedIndices[i];
+			if (index == AGGREGATOR_RING_SIZE) {
+				terminated = 1;
+				continue;
+			}
+
+			// Pass on that the region is done, after its last reports, once every node of the region has sent an empty report
+			MPI_Get_count(&completedStatuses[i], receiveType, &size);
+			if (size == 0) {
+				if (++doneCount == regionSize) {
+					if (batch.reportsCount > 0) {
+						counts[0] += batch.reportsCount;
+						counts[1]++;
+						sendBatch(commWorld, baseRank, &batch);
+					}
+					MPI_Send(NULL, 0, MPI_BYTE, baseRank, REPORT_BATCH_TAG, commWorld);
+				}
+				MPI_Irecv(ringBuffers[index], receiveCount, receiveType, MPI_ANY_SOURCE, REPORT_TAG, reportComm, &requests[index]);
+				continue;
+			}
+
+			// Send the batch first if the report does not fit
+			if (reportFormat == REPORT_FIXED) size = sizeof(Report);
+			else MPI_Get_count(&completedStatuses[i], MPI_PACKED, &size);
+			if (batch.size + (int) sizeof(int) + size > AGGREGATOR_BATCH_SIZE) {
+				counts[0] += batch.reportsCount;
+				counts[1]++;
+				sendBatch(commWorld, baseRank, &batch);
+			}
+			addToBatch(&batch, ringBuffers[index], size);
+			MPI_Irecv(ringBuffers[index], receiveCount, receiveType, MPI_ANY_SOURCE, REPORT_TAG, reportComm, &requests[index]);
+		}
+	}
+
+	// Cancel the receives still posted, the base station has stopped listening
+	for (i = 0; i < AGGREGATOR_RING_SIZE; i++) {
+		MPI_Cancel(&requests[i]);
+		MPI_Wait(&requests[i], MPI_STATUS_IGNORE);
+	}
+	free(ringBuffers);
+
+	// Tell the base station this aggregator has closed, after every batch it sent, so the base station matches them all
+	MPI_Send(NULL, 0, MPI_BYTE, baseRank, AGGREGATOR_CLOSED_TAG, commWorld);
+
+	// Summarize the batching and resource usage of all aggregators
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+	MPI_Reduce(counts, totalCounts, 2, MPI_LONG, MPI_SUM, 0, comm);
+	if (rank == 0 && totalCounts[1] > 0) {
+		printf("Aggregators: %ld reports forwarded in %ld batches (%.1f reports/batch)\n", totalCounts[0], totalCounts[1], (double) totalCounts[0] / totalCounts[1]);
+		fflush(stdout);
+	}
+	reportResourceUsage(comm, "Aggregator", 0);
+	sumCPUTime(commWorld);
+}
+
+
+int getNodeRegion(int nodeRank) {
+	/**
+	 * Returns the region (and so the aggregator) of a node rank, the regions being even bands of grid rows 
+	 * and each node belonging to the band of its first sensor
+	 */
+
+	int firstRow = (int) ((long) (nodeRank / tileGrid[1]) * rows / tileGrid[0]);
+	return (int) ((long) firstRow * aggregatorsCount / rows);
+}
+
+
+void addToBatch(ReportBatch* batch, char* report, int size) {
+	/**
+	 * Appends the packed bytes of a report to the batch
+	 */
+
+	memcpy(batch->buffer + batch->size, &size, sizeof(int));
+	memcpy(batch->buffer + batch->size + sizeof(int), report, size);
+	batch->size += sizeof(int) + size;
+	batch->reportsCount++;
+}
+
+
+void sendBatch(MPI_Comm commWorld, int baseRank, ReportBatch* batch) {
+	/**
+	 * Sends the batch to the base station with the number of reports in front, and empties it
+	 */
+
+	memcpy(batch->buffer, &batch->reportsCount, sizeof(int));
+	MPI_Send(batch->buffer, batch->size, MPI_PACKED, baseRank, REPORT_BATCH_TAG, commWorld);
+	batch->size = sizeof(int);
+	batch->reportsCount = 0;
+}
+
@@ -0,0 +1,24 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+// Define aggregator constants
+#define AGGREGATOR_RING_SIZE 16 // report receives each aggregator keeps posted for the nodes of its region
+#define AGGREGATOR_BATCH_SIZE 2048 // bytes of a batch, at most REPORT_BUFFER_SIZE for the base station to receive it
+
+
+// Define ReportBatch structure, to store the reports an aggregator forwards to the base station in one message.
+// The buffer holds the number of reports, then the size and packed bytes of each report as sent by its node
+typedef struct {
+	char buffer[AGGREGATOR_BATCH_SIZE];
+	int size;
+	int reportsCount;
+} ReportBatch;
+
+
+// Function definitions for aggregator.c
+void aggregator(MPI_Comm commWorld, MPI_Comm comm);
+int getNodeRegion(int nodeRank);
+void addToBatch(ReportBatch* batch, char* report, int size);
+void sendBatch(MPI_Comm commWorld, int baseRank, ReportBatch* batch);
+
+#endif
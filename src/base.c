@@ -8,14 +8,20 @@
 
 #include "./init.h"
 #include "./base.h"
+#include "./logger.h"
+#include "./rng.h"
+#include "./tile.h"
+#include "./report.h"
+#include "./record.h"
+#include "./simclock.h"
 
 
 // Define global variables
-pthread_mutex_t infraredTimeMutex;
-pthread_mutex_t infraredValueMutex;
-SatelliteData* simulatedValues = NULL;
-char** macAddresses = NULL;
-char** ipAddresses = NULL;
+SatelliteHistory satelliteHistory;
+RecordFile frameRecord;
+int* frameValues = NULL;
+NodeAddress* nodeAddresses = NULL;
+double* clockOffsets = NULL;
 int userStop;
 double simStartTime;
 
@@ -25,276 +31,529 @@ void base(MPI_Comm commWorld, MPI_Comm comm) {
 	 * Base station function
 	 */
 
-	// Get the size of the entire communication and the the grid size
-	int size;
-	MPI_Comm_size(commWorld, &size);
-	int cartSize = size-1;	
+	// Get the grid size
+	int sensorsCount = rows * cols;
+
+	// Measures the clock offsets of the nodes, before any report is timed
+	clockOffsets = synchronizeClocks(commWorld);
+
+	// Receives the MAC and IP address from all nodes, as they start up
+	receiveAddresses(commWorld);
 
 	// Starts the simulation time
 	simStartTime = MPI_Wtime();
 
-	// Constructs infrared simulation
-	constructInfrared(cartSize);
+	// Constructs infrared simulation, with every recorded frame if replaying
+	if (replayPrefix != NULL) replayFrames(sensorsCount);
+	else constructInfrared(sensorsCount);
 	
-	// Creates a thread to simulate the temperatures
+	// Creates a thread to simulate the temperatures, recording them if asked. On the virtual clock, 
+	// the frames are simulated as the reports reach their time instead
 	pthread_t tid_satellite;
-	pthread_create(&tid_satellite, 0, threadSimulation, &cartSize);
+	int satelliteThread = replayPrefix == NULL && !isVirtualClock();
+	if (recordPrefix != NULL && openRecord(&frameRecord, recordPrefix, RECORD_FRAMES, sensorsCount) != 0) 
+		MPI_Abort(commWorld, 1);
+	if (satelliteThread) 
+		pthread_create(&tid_satellite, 0, threadSimulation, &sensorsCount);
 		
-	// Creates a thread to check for user stopping
+	// Creates a thread to check for user stopping, unless running headless
 	pthread_t tid_userStop;
 	userStop = 0;
-	pthread_create(&tid_userStop, 0, checkStop, NULL);
-
-	// Receives the MAC and IP address from all nodes
-	receiveMACAndIPAddress(commWorld, cartSize);
+	if (!benchmarkMode) 
+		pthread_create(&tid_userStop, 0, checkStop, NULL);
 	
 	// Start listening to events from nodes
-	listenForReports(commWorld);
-
-	// Sends termination signal to all nodes in the grid
-	int i, terminated = 1;
-	for (i = 1; i < size; i++) {
-		MPI_Send(&terminated, 1, MPI_INT, i, TERMINATION_TAG, commWorld); 
+	ReportStatistics statistics;
+	initReportStatistics(&statistics, sensorsCount);
+	listenForReports(commWorld, &statistics);
+
+	// Broadcasts the termination signal to all nodes and aggregators, and receives the batches still on their way
+	broadcastTermination();
+	if (aggregatorsCount > 0) 
+		drainAggregators(commWorld);
+
+	// Stops the thread from running, and writes out the frames recorded
+	if (satelliteThread) {
+		pthread_cancel(tid_satellite);
+		pthread_join(tid_satellite, NULL);
 	}
-
-	// Stops the thread from running
-	pthread_cancel(tid_satellite);
-	pthread_cancel(tid_userStop);
+	if (recordPrefix != NULL) 
+		closeRecord(&frameRecord);
+	if (!benchmarkMode) 
+		pthread_cancel(tid_userStop);
 
 	// Destructs infrared simulation
 	destructInfrared();
 
+	// Sums the CPU time of all processes once the nodes have terminated
+	double totalCPUTime = sumCPUTime(commWorld);
+
+	// Print the machine-readable benchmark result
+	if (benchmarkMode) {
+		int alertsCount = statistics.trueAlertsCount + statistics.falseAlertsCount;
+		printf("RESULT rows=%d cols=%d nodes=%d reports=%d listen_s=%.3f reports_per_s=%.1f true_alerts=%d false_alerts=%d comm_p50_ms=%.3f comm_p99_ms=%.3f cpu_s=%.3f seed=%llu events=%ld\n", 
+			rows, cols, sensorsCount, alertsCount, statistics.listenTime, alertsCount / statistics.listenTime, statistics.trueAlertsCount, statistics.falseAlertsCount, 
+			getValueAtPercentile(&statistics.commTimes, 50) / 1e6, getValueAtPercentile(&statistics.commTimes, 99) / 1e6, totalCPUTime, randomSeed, statistics.clusters.eventsCount);
+		fflush(stdout);
+	}
+	freeReportStatistics(&statistics);
+	free(clockOffsets);
+	free(nodeAddresses);
+
 	printf("Base terminated!\n");
 }
 
 
-void receiveMACAndIPAddress(MPI_Comm commWorld, int cartSize) {
+void receiveAddresses(MPI_Comm commWorld) {
 	/**
-	 * Receives the MAC and IP Addresses from nodes and store them in arrays
+	 * Gathers the MAC and IP addresses of all nodes into one array, indexed by node
 	 */
-	
-	int position, i; 
-	char addressBuffer[ADDRESS_BUFFER_SIZE];
+
+	NodeAddress address;
+	nodeAddresses = gatherAddresses(commWorld, &address);
+
+	// Drop the base station's own address in front of the nodes'
+	memmove(nodeAddresses, nodeAddresses + 1, nodesCount * sizeof(NodeAddress));
+}
+
+
+void drainAggregators(MPI_Comm commWorld) {
+	/**
+	 * Receives and drops the batches the aggregators sent after the base station stopped listening, until every aggregator 
+	 * has closed. An aggregator closes after its last batch, so none is left unmatched when MPI is finalized. Only the 
+	 * batch and close tags are received, and each aggregator rank closes once
+	 */
+
+	int index, completed, closedCount = 0, firstAggregator = 1 + nodesCount;
+	int* closed = (int*) calloc(aggregatorsCount, sizeof(int));
+	char* buffer = (char*) malloc(REPORT_BUFFER_SIZE);
+	MPI_Request requests[2];
 	MPI_Status status;
 
-	// Allocates size for MAC address
-	macAddresses = (char**) malloc(cartSize * sizeof(char*));
-	for (i = 0; i < cartSize; i++) 
-		macAddresses[i] = (char*) malloc(18 * sizeof(char));
-	
-	// Allocates size for IP address
-	ipAddresses = (char**) malloc(cartSize * sizeof(char*));
-	for (i = 0; i < cartSize; i++) 
-		ipAddresses[i] = (char*) malloc(16 * sizeof(char));
-
-	// Receives the address buffer from all rank 1 to last rank 
-	for (i = 1; i <= cartSize; i++) {
-		position = 0;
-		MPI_Recv(addressBuffer, ADDRESS_BUFFER_SIZE, MPI_PACKED, i, ADDRESSES_TAG, commWorld, &status);
-		MPI_Unpack(addressBuffer, ADDRESS_BUFFER_SIZE, &position, macAddresses[i-1], 18, MPI_CHAR, commWorld);
-		MPI_Unpack(addressBuffer, ADDRESS_BUFFER_SIZE, &position, ipAddresses[i-1], 16, MPI_CHAR, commWorld);
+	MPI_Irecv(buffer, REPORT_BUFFER_SIZE, MPI_PACKED, MPI_ANY_SOURCE, REPORT_BATCH_TAG, commWorld, &requests[0]);
+	MPI_Irecv(NULL, 0, MPI_BYTE, MPI_ANY_SOURCE, AGGREGATOR_CLOSED_TAG, commWorld, &requests[1]);
+	while (closedCount < aggregatorsCount) {
+		MPI_Waitany(2, requests, &index, &status);
+		if (index == 1) {
+			if (!closed[status.MPI_SOURCE - firstAggregator]) {
+				closed[status.MPI_SOURCE - firstAggregator] = 1;
+				closedCount++;
+			}
+			if (closedCount < aggregatorsCount) 
+				MPI_Irecv(NULL, 0, MPI_BYTE, MPI_ANY_SOURCE, AGGREGATOR_CLOSED_TAG, commWorld, &requests[1]);
+		} else 
+			MPI_Irecv(buffer, REPORT_BUFFER_SIZE, MPI_PACKED, MPI_ANY_SOURCE, REPORT_BATCH_TAG, commWorld, &requests[0]);
 	}
-}
 
+	// The batches sent before the last close have arrived with it, drop those still waiting before giving up the receive
+	MPI_Test(&requests[0], &completed, MPI_STATUS_IGNORE);
+	while (completed) {
+		MPI_Irecv(buffer, REPORT_BUFFER_SIZE, MPI_PACKED, MPI_ANY_SOURCE, REPORT_BATCH_TAG, commWorld, &requests[0]);
+		MPI_Test(&requests[0], &completed, MPI_STATUS_IGNORE);
+	}
+	MPI_Cancel(&requests[0]);
+	MPI_Wait(&requests[0], MPI_STATUS_IGNORE);
+	free(closed);
+	free(buffer);
+}
 
 
-void listenForReports(MPI_Comm commWorld) {
+void listenForReports(MPI_Comm commWorld, ReportStatistics* statistics) {
 	/**
 	 * Listens for incoming reports from nodes
 	 */
 	
-	int flag, position, i, count = 0;
+	int i, flag, received, count = 0;
+	int doneCount = 0, sendersCount = aggregatorsCount > 0? aggregatorsCount: nodesCount;
 
 	// Initialize the buffer to receive from node
 	char reportBuffer[REPORT_BUFFER_SIZE];
 
-	// Initialize the structures to unpack from the buffer
-	Alert alert;
-	NodeInfo* neighboursNodeInfo;
-	NodeInfo reportingNode;
-	int neighboursCount;
-
 	// Initialize local variables
-	time_t now;
 	MPI_Status status;
-		
-	double commTime;
-	double longestCommTime = 0;
-	double shortestCommTime = 0;
-	double totalCommTime = 0;
-	int trueAlertsCount = 0;
-	int falseAlertsCount = 0;
-
-	FILE* baseFilePtr = fopen("base_log.txt", "w");;
 
-	// Start running
-	while (count < baseIterationsCount) { 
-		position = 0;
-			
-		// Stops listening if user enters stop
-		if (userStop) break;
-
-		MPI_Recv(reportBuffer, REPORT_BUFFER_SIZE, MPI_PACKED, MPI_ANY_SOURCE, REPORT_TAG, commWorld, &status);
-		printf("Base received report from rank %d\n", status.MPI_SOURCE-1);
-	
-		MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &alert, 1, AlertType, commWorld);
+	// Receive batches from the aggregators if there are any, or else reports from the nodes
+	int reportTag = aggregatorsCount > 0? REPORT_BATCH_TAG: REPORT_TAG;
+
+	// Receive fixed-size reports from the nodes straight into the records they are validated and logged from, 
+	// and everything else as bytes to decode
+	int fixedReports = (reportTag == REPORT_TAG && reportFormat == REPORT_FIXED);
+	MPI_Datatype receiveType = fixedReports? ReportType: MPI_PACKED;
+	int receiveCount = fixedReports? 1: REPORT_BUFFER_SIZE;
+	ReportRecord receivedRecord;
+
+	// Initialize the ring of pre-posted receives, each slot a record for fixed-size reports or a buffer otherwise
+	MPI_Request ringRequests[reportRingSize > 0? reportRingSize: 1];
+	int completedIndices[reportRingSize > 0? reportRingSize: 1];
+	MPI_Status completedStatuses[reportRingSize > 0? reportRingSize: 1];
+	char (*ringBuffers)[REPORT_BUFFER_SIZE] = NULL;
+	ReportRecord* ringRecords = NULL;
+	void* ringSlot;
+	int completedCount;
+
+	if (reportRingSize > 0) {
+		if (fixedReports) ringRecords = (ReportRecord*) malloc(reportRingSize * sizeof(ReportRecord));
+		else ringBuffers = (char (*)[REPORT_BUFFER_SIZE]) malloc(reportRingSize * sizeof(*ringBuffers));
+		for (i = 0; i < reportRingSize; i++) {
+			ringSlot = fixedReports? (void*) &ringRecords[i].report: (void*) ringBuffers[i];
+			MPI_Irecv(ringSlot, receiveCount, receiveType, MPI_ANY_SOURCE, reportTag, commWorld, &ringRequests[i]);
+		}
+	}
 
-		MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &reportingNode, 1, NodeInfoType, commWorld);
+	// Format and write the log on a background writer thread
+	FILE* baseFilePtr = fopen("base_log.txt", "w");
+	ReportLogger logger;
+	startReportLogger(&logger, baseFilePtr);
 
-		MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &neighboursCount, 1, MPI_INT, commWorld);
-		neighboursNodeInfo = (NodeInfo*) malloc(neighboursCount * sizeof(NodeInfo));
+	// Write one event per fire, merging the reports of adjacent sensors
+	FILE* eventsFilePtr = fopen("events_log.txt", "w");
+	initEventClusters(&statistics->clusters, rows * cols, eventsFilePtr);
+	double listenStartTime = MPI_Wtime();
 
-		// Unpack each neighbour
-		for (i = 0; i < neighboursCount; i++) 
-			MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &neighboursNodeInfo[i], 1, NodeInfoType, commWorld);
-		
-		time(&now);
+	// Start running, until every node (or aggregator) of a replay or virtual clock run is done
+	while (count < baseIterationsCount && doneCount < sendersCount) { 
+			
+		// Stops listening if user enters stop or the duration has passed, but a run on the virtual clock goes on to its horizon
+		if (userStop && !isVirtualClock()) break;
+		if (duration > 0 && MPI_Wtime() - listenStartTime >= duration) break;
+
+		if (reportRingSize > 0) {
+			// Wake up and drain every report that has completed in the ring, blocking only if none has
+			MPI_Testsome(reportRingSize, ringRequests, &completedCount, completedIndices, completedStatuses);
+			if (completedCount == 0) {
+				// Keep polling instead to stop in time, or to leave the CPU to the nodes of a finite run
+				if (duration > 0 || finiteRun) {
+					usleep(BASE_POLL_INTERVAL);
+					continue;
+				}
+				MPI_Waitsome(reportRingSize, ringRequests, &completedCount, completedIndices, completedStatuses);
+			}
 
-		commTime = MPI_Wtime() - alert.commStartTime - NODE_DELAYS;
-		commTime = commTime < 0? 0: commTime;
-		totalCommTime += commTime;
-	 	longestCommTime = (longestCommTime > commTime)? longestCommTime: commTime;
-	 	shortestCommTime = (shortestCommTime < commTime)? shortestCommTime: commTime;
+			// Process the batch, and re-post each receive as soon as its report is processed, until the iterations count is reached
+			for (i = 0; i < completedCount; i++) {
+				MPI_Get_count(&completedStatuses[i], receiveType, &received);
+				if (received == 0) doneCount++; // an empty report: the sender is done
+				else if (fixedReports) count = processFixedReport(&ringRecords[completedIndices[i]], count, statistics, &logger);
+				else count = processMessage(commWorld, ringBuffers[completedIndices[i]], reportTag, count, statistics, &logger);
+				if (count >= baseIterationsCount) continue;
+				ringSlot = fixedReports? (void*) &ringRecords[completedIndices[i]].report: (void*) ringBuffers[completedIndices[i]];
+				MPI_Irecv(ringSlot, receiveCount, receiveType, MPI_ANY_SOURCE, reportTag, commWorld, &ringRequests[completedIndices[i]]);
+			}
+		} else {
+			// Keep polling instead to stop in time, or to leave the CPU to the nodes of a finite run
+			if (duration > 0 || finiteRun) {
+				MPI_Iprobe(MPI_ANY_SOURCE, reportTag, commWorld, &flag, MPI_STATUS_IGNORE);
+				if (!flag) {
+					usleep(BASE_POLL_INTERVAL);
+					continue;
+				}
+			}
+			MPI_Recv(fixedReports? (void*) &receivedRecord.report: (void*) reportBuffer, receiveCount, receiveType, MPI_ANY_SOURCE, reportTag, commWorld, &status);
+			MPI_Get_count(&status, receiveType, &received);
+			if (received == 0) doneCount++; // an empty report: the sender is done
+			else if (fixedReports) count = processFixedReport(&receivedRecord, count, statistics, &logger);
+			else count = processMessage(commWorld, reportBuffer, reportTag, count, statistics, &logger);
+		}
 		
-		// Initialize a SatelliteAlert to obtain the satellite information matched
-		SatelliteAlert satelliteAlert;
-		satelliteAlert.satelliteTime = 0;
-		satelliteAlert.satelliteTemperature = 0;
+		// Let the iteration interval pass
+		advanceClock(baseInterval);
+	}
 
-		int trueAlert = isWithinThreshold(&reportingNode, &alert, &satelliteAlert);
-		trueAlert? trueAlertsCount++: falseAlertsCount++;
-		
-		fprintf(baseFilePtr, "============================================================\n");
-		fprintf(baseFilePtr, "Iteration: %d\n", count);
-		fprintf(baseFilePtr, "Logged Time: %s", asctime(localtime(&now)));
-
-		fprintf(baseFilePtr, "\n");
-		fprintf(baseFilePtr, "Alert Reported Time: %s", asctime(localtime(&alert.timestamp)));
-		fprintf(baseFilePtr, "Alert Type: %s\n", trueAlert? "True": "False");
-		fprintf(baseFilePtr, "Number of Adjacent Matches to Reporting Node: %d\n", alert.matchCount);
-		fprintf(baseFilePtr, "Communication Time (seconds): %f\n", commTime);
-
-		fprintf(baseFilePtr, "\n");
-		fprintf(baseFilePtr, "Reporting Node Information:\n");
-		fprintf(baseFilePtr, "\t\tRank: %d\n", reportingNode.rank);
-		fprintf(baseFilePtr, "\t\tCoordinate: (%d, %d)\n", reportingNode.coord[0], reportingNode.coord[1]);
-		fprintf(baseFilePtr, "\t\tTemperature: %d\n", reportingNode.temperature);
-		fprintf(baseFilePtr, "\t\tMAC Address: %s\n", macAddresses[reportingNode.rank]);
-		fprintf(baseFilePtr, "\t\tIP Address: %s\n", ipAddresses[reportingNode.rank]);
-
-		fprintf(baseFilePtr, "\n");
-		fprintf(baseFilePtr, "Adjacent Nodes Information:\n");
-		for (i = 0; i < neighboursCount; i++) {
-			fprintf(baseFilePtr, "\t\tRank: %d\n", neighboursNodeInfo[i].rank);
-			fprintf(baseFilePtr, "\t\tCoordinate: (%d, %d)\n", neighboursNodeInfo[i].coord[0], neighboursNodeInfo[i].coord[1]);
-			fprintf(baseFilePtr, "\t\tTemperature: %d\n", neighboursNodeInfo[i].temperature);
-			fprintf(baseFilePtr, "\t\tMAC Address: %s\n", macAddresses[neighboursNodeInfo[i].rank]);
-			fprintf(baseFilePtr, "\t\tIP Address: %s\n", ipAddresses[neighboursNodeInfo[i].rank]);
-			fprintf(baseFilePtr, "\t\t-------------------------\n");
+	// Report the ingestion throughput
+	double listenTime = MPI_Wtime() - listenStartTime;
+	statistics->listenTime = listenTime;
+	printf("Base processed %d reports in %.3f seconds (%.1f reports/second)\n", count, listenTime, count / listenTime);
+	fflush(stdout);
+
+	// Cancel the receives still posted in the ring
+	if (reportRingSize > 0) {
+		for (i = 0; i < reportRingSize; i++) {
+			if (ringRequests[i] == MPI_REQUEST_NULL) continue;
+			MPI_Cancel(&ringRequests[i]);
+			MPI_Wait(&ringRequests[i], MPI_STATUS_IGNORE);
 		}
-
-		fprintf(baseFilePtr, "\n");
-		fprintf(baseFilePtr, "Infrared Satellite Information:\n");
-		fprintf(baseFilePtr, "\t\tReporting Time: %s", asctime(localtime(&satelliteAlert.satelliteTime)));
-		fprintf(baseFilePtr, "\t\tReporting Temperature: %d\n", satelliteAlert.satelliteTemperature);
-		
-		// Sleep in microseconds
-		usleep(baseInterval * 1e6);
-		count++;
+		free(ringBuffers);
+		free(ringRecords);
 	}
 
+	// Wait for every report to be logged before the summary, and close the events still open
+	stopReportLogger(&logger);
+	freeEventClusters(&statistics->clusters);
+	fclose(eventsFilePtr);
+	printf("Base merged %ld reports into %ld events (%.1f reports/event)\n", statistics->clusters.clusteredReportsCount, statistics->clusters.eventsCount, 
+		statistics->clusters.eventsCount > 0? (double) statistics->clusters.clusteredReportsCount / statistics->clusters.eventsCount: 0);
+	fflush(stdout);
+
 	fprintf(baseFilePtr, "==================================================\n");
 	fprintf(baseFilePtr, "\t\tSummary Report\n");
 	fprintf(baseFilePtr, "==================================================\n");
 	
 	fprintf(baseFilePtr, "Total Simulation Time (seconds): %f\n", MPI_Wtime() - simStartTime);
-	fprintf(baseFilePtr, "Shortest Communication Time (seconds): %f\n", shortestCommTime);
-	fprintf(baseFilePtr, "Longest Communication Time (seconds): %f\n", longestCommTime);
+	fprintf(baseFilePtr, "Communication Time (seconds): ");
+	printCommTimePercentiles(baseFilePtr, &statistics->commTimes);
 
 	fprintf(baseFilePtr, "\n");
-	fprintf(baseFilePtr, "Total Communication Time (seconds): %f\n", totalCommTime);
+	fprintf(baseFilePtr, "Total Communication Time (seconds): %f\n", statistics->totalCommTime);
 	fprintf(baseFilePtr, "Total Messages Received: %d\n", count);
-	fprintf(baseFilePtr, "Average Communication Time (seconds): %f\n", totalCommTime / count);
+	fprintf(baseFilePtr, "Average Communication Time (seconds): %f\n", count > 0? statistics->totalCommTime / count: 0);
+
+	// Break the communication times down per neighbour count and per reporting rank
+	fprintf(baseFilePtr, "\n");
+	fprintf(baseFilePtr, "Communication Time by Neighbour Count (seconds):\n");
+	for (i = 2; i <= MAX_NEIGHBOURS; i++) {
+		fprintf(baseFilePtr, "\t%d neighbours: ", i);
+		printCommTimePercentiles(baseFilePtr, &statistics->neighboursCommTimes[i]);
+	}
 
 	fprintf(baseFilePtr, "\n");
-	fprintf(baseFilePtr, "Total True Alerts Count: %d\n", trueAlertsCount);
-	fprintf(baseFilePtr, "Total False Alerts Count: %d\n", falseAlertsCount);
+	fprintf(baseFilePtr, "Communication Time by Reporting Node (seconds):\n");
+	for (i = 0; i < statistics->ranksCount; i++) {
+		if (statistics->rankCommTimes[i] == NULL) continue;
+		fprintf(baseFilePtr, "\tRank %d: ", i);
+		printCommTimePercentiles(baseFilePtr, statistics->rankCommTimes[i]);
+	}
+
+	fprintf(baseFilePtr, "\n");
+	fprintf(baseFilePtr, "Total True Alerts Count: %d\n", statistics->trueAlertsCount);
+	fprintf(baseFilePtr, "Total False Alerts Count: %d\n", statistics->falseAlertsCount);
+	fprintf(baseFilePtr, "Total Events Count: %ld (see events_log.txt)\n", statistics->clusters.eventsCount);
 
 	fclose(baseFilePtr);
 
-	// free dynamic array
-	free(neighboursNodeInfo);
+}
 
+
+int processMessage(MPI_Comm commWorld, char* messageBuffer, int tag, int count, ReportStatistics* statistics, ReportLogger* logger) {
+	/**
+	 * Processes a report, or each report of a batch from an aggregator, up to the base station's iterations count. 
+	 * Returns the number of reports processed so far
+	 */
+
+	int i, reportsCount, reportSize, position = sizeof(int);
+
+	if (tag == REPORT_TAG) 
+		return processNodeMessage(commWorld, messageBuffer, count, statistics, logger);
+
+	// A batch holds the number of reports, then the size and packed bytes of each report
+	memcpy(&reportsCount, messageBuffer, sizeof(int));
+	for (i = 0; i < reportsCount && count < baseIterationsCount; i++) {
+		memcpy(&reportSize, messageBuffer + position, sizeof(int));
+		count = processNodeMessage(commWorld, messageBuffer + position + sizeof(int), count, statistics, logger);
+		position += sizeof(int) + reportSize;
+	}
+	return count;
 }
 
 
-int isWithinThreshold(NodeInfo* reportingNode, Alert* alert, SatelliteAlert* satelliteAlert) {
+int processFixedReport(ReportRecord* record, int count, ReportStatistics* statistics, ReportLogger* logger) {
 	/**
-	 * Returns true if the reporting node's temperature matches with the simulated temperature by a threshold value and false otherwise
+	 * Validates a fixed-size report received in place into the record, up to the base station's iterations count. 
+	 * Returns the number of reports processed so far
 	 */
-	
-	int rank = reportingNode->rank;
-	int i, j, infraredTemperature;
-	time_t now;
 
-	// Go through all time units
-	for (i = 0; i < TIME_UNITS; i++) {
-		pthread_mutex_lock(&infraredTimeMutex); // lock with mutex
-		now = simulatedValues[i].timestamp; // read from infrared simulation
-		pthread_mutex_unlock(&infraredTimeMutex);
+	if (count >= baseIterationsCount) return count;
+	record->iteration = count;
+	validateReport(record, statistics, logger);
+	return count + 1;
+}
+
 
-		// Continue if timestamp is not yet set (thread still running, data not generated)
-		if (now == 0) continue;
-		satelliteAlert->satelliteTime = now;
-		
-		// Checks if alert's time and simulated time is within a fixed time window
-		if (labs(now - alert->timestamp) <= TIME_WINDOW) {
-			pthread_mutex_lock(&infraredValueMutex); // lock with mutex
-			infraredTemperature = simulatedValues[i].values[rank]; // read the temperature
-			pthread_mutex_unlock(&infraredValueMutex);
+int processNodeMessage(MPI_Comm commWorld, char* messageBuffer, int count, ReportStatistics* statistics, ReportLogger* logger) {
+	/**
+	 * Processes the message of a node, a packed or fixed-size report or each alert of a compact message up to 
+	 * the base station's iterations count. Returns the number of reports processed so far
+	 */
 
-			satelliteAlert->satelliteTemperature = infraredTemperature;
-			
-			// Checks if the node's temperature matches the simulated temperature by a threshold
-			if (abs(infraredTemperature - reportingNode->temperature) <= TOLERANCE) {
-				return 1;
-			}
+	int i, alertsCount;
+	ReportRecord record;
+
+	if (count >= baseIterationsCount) return count;
+	if (reportFormat == REPORT_PACKED) {
+		processReport(commWorld, messageBuffer, count, statistics, logger);
+		return count + 1;
+	}
+
+	// A fixed-size report of a batch is copied out, as it may not be aligned
+	if (reportFormat == REPORT_FIXED) {
+		record.iteration = count;
+		record.report.neighboursCount = decodeFixedReport(messageBuffer, &record.report.alert, &record.report.reportingNode, record.report.neighboursNodeInfo);
+		validateReport(&record, statistics, logger);
+		return count + 1;
+	}
+
+	// The fixed layout is read in place, the alerts following the header
+	alertsCount = ((CompactReportHeader*) messageBuffer)->alertsCount;
+	for (i = 0; i < alertsCount && count < baseIterationsCount; i++) {
+		record.iteration = count;
+		record.report.neighboursCount = decodeCompactAlert(messageBuffer, i, &record.report.alert, &record.report.reportingNode, record.report.neighboursNodeInfo);
+		if (record.report.neighboursCount < 0) {
+			printf("Base ignored a report of an unknown format version\n");
+			break;
 		}
+		validateReport(&record, statistics, logger);
+		count++;
 	}
-	return 0;
+	return count;
 }
 
 
+void processReport(MPI_Comm commWorld, char* reportBuffer, int count, ReportStatistics* statistics, ReportLogger* logger) {
+	/**
+	 * Unpacks a report received from a node and validates it
+	 */
+
+	// Initialize the record to unpack the buffer into
+	ReportRecord record;
+	record.iteration = count;
+	record.report.neighboursCount = unpackReport(commWorld, reportBuffer, &record.report.alert, &record.report.reportingNode, record.report.neighboursNodeInfo);
+
+	validateReport(&record, statistics, logger);
+}
+
 
-void printSimulatedValues(FILE* fptr, int size) {
+void validateReport(ReportRecord* record, ReportStatistics* statistics, ReportLogger* logger) {
 	/**
-	 * Logs the simulated values 
+	 * Validates a report against the infrared satellite, records its communication time and logs it
 	 */
-	
-	int value, i, j;
+
+	// Initialize local variables
 	time_t now;
+	double commTime;
+
+	if (!benchmarkMode) 
+		printf("Base received report from rank %d\n", record->report.reportingNode.rank);
+	
+	time(&now);
+	record->loggedTime = now;
+
+	// Convert the send time to the base station's clock, by the offset of the process simulating the reporting node
+	commTime = MPI_Wtime() - (record->report.alert.commStartTime + clockOffsets[getSensorOwner(record->report.reportingNode.rank) + 1]);
+	commTime = commTime < 0? 0: commTime;
+	record->commTime = commTime;
+	recordCommTime(statistics, record->report.reportingNode.rank, record->report.neighboursCount, commTime);
+	
+	// Initialize a SatelliteAlert to obtain the satellite information matched
+	record->satelliteAlert.satelliteTime = 0;
+	record->satelliteAlert.satelliteTemperature = 0;
+
+	// On the virtual clock, the satellite catches up with the report, up to the end of its time window
+	if (isVirtualClock()) 
+		simulateFramesUntil(record->report.alert.timestamp + TIME_WINDOW);
+
+	record->trueAlert = isWithinThreshold(&record->report.reportingNode, &record->report.alert, &record->satelliteAlert);
+	record->trueAlert? statistics->trueAlertsCount++: statistics->falseAlertsCount++;
+
+	// Merge the report into the event of the fire it belongs to
+	addToClusters(&statistics->clusters, record->report.reportingNode.rank, 
+		record->report.reportingNode.coord[0] * cols + record->report.reportingNode.coord[1], record->report.alert.timestamp, record->report.reportingNode.temperature, record->trueAlert, 
+		record->report.neighboursNodeInfo, record->report.neighboursCount);
+
+	// Hand the record to the writer thread
+	logReport(logger, record);
+}
+
+
+void initReportStatistics(ReportStatistics* statistics, int ranksCount) {
+	/**
+	 * Initializes the statistics with empty histograms, the per-rank histograms are allocated on the first report
+	 */
+
+	int i;
+
+	statistics->totalCommTime = 0;
+	statistics->trueAlertsCount = 0;
+	statistics->falseAlertsCount = 0;
+	statistics->listenTime = 0;
+	initHistogram(&statistics->commTimes, HISTOGRAM_PRECISION);
+	for (i = 0; i <= MAX_NEIGHBOURS; i++) 
+		initHistogram(&statistics->neighboursCommTimes[i], HISTOGRAM_PRECISION);
+	statistics->rankCommTimes = (Histogram**) calloc(ranksCount, sizeof(Histogram*));
+	statistics->ranksCount = ranksCount;
+}
+
+
+void freeReportStatistics(ReportStatistics* statistics) {
+	/**
+	 * Frees the histograms of the statistics
+	 */
+
+	int i;
+
+	freeHistogram(&statistics->commTimes);
+	for (i = 0; i <= MAX_NEIGHBOURS; i++) 
+		freeHistogram(&statistics->neighboursCommTimes[i]);
+	for (i = 0; i < statistics->ranksCount; i++) {
+		if (statistics->rankCommTimes[i] == NULL) continue;
+		freeHistogram(statistics->rankCommTimes[i]);
+		free(statistics->rankCommTimes[i]);
+	}
+	free(statistics->rankCommTimes);
+}
+
+
+void recordCommTime(ReportStatistics* statistics, int reportingRank, int neighboursCount, double commTime) {
+	/**
+	 * Counts the communication time of a report from the given sensor into the histograms
+	 */
+
+	long long nanoseconds = (long long) (commTime * 1e9);
+
+	statistics->totalCommTime += commTime;
+	recordValue(&statistics->commTimes, nanoseconds);
+	if (neighboursCount >= 0 && neighboursCount <= MAX_NEIGHBOURS) 
+		recordValue(&statistics->neighboursCommTimes[neighboursCount], nanoseconds);
+
+	// Allocate the histogram of a rank on its first report, at a lower precision as there may be many ranks
+	if (statistics->rankCommTimes[reportingRank] == NULL) {
+		statistics->rankCommTimes[reportingRank] = (Histogram*) malloc(sizeof(Histogram));
+		initHistogram(statistics->rankCommTimes[reportingRank], HISTOGRAM_RANK_PRECISION);
+	}
+	recordValue(statistics->rankCommTimes[reportingRank], nanoseconds);
+}
+
+
+void printCommTimePercentiles(FILE* fptr, Histogram* histogram) {
+	/**
+	 * Prints the count, percentiles and maximum of a histogram of communication times on one line
+	 */
+
+	fprintf(fptr, "%ld reports, p50 %f, p90 %f, p99 %f, p99.9 %f, max %f\n", histogram->totalCount, 
+		getValueAtPercentile(histogram, 50) / 1e9, getValueAtPercentile(histogram, 90) / 1e9, getValueAtPercentile(histogram, 99) / 1e9, 
+		getValueAtPercentile(histogram, 99.9) / 1e9, histogram->maxValue / 1e9);
+}
+
 
-	// Go through all time units
-	for (i = 0; i < TIME_UNITS; i++) {
-		pthread_mutex_lock(&infraredTimeMutex); // lock with mutex
-		now = simulatedValues[i].timestamp; // read
-		pthread_mutex_unlock(&infraredTimeMutex);
-
-		// Log the timestamp for generating the temperatures 
-		fprintf(fptr,"==============\n");
-		if (now != 0)
-			fprintf(fptr, "TIME[%d] = %ld = %s\n", i, now, asctime(localtime(&now)));
-		else 
-			fprintf(fptr, "TIME[%d] = 0\n", i);
-
-		// Log the temperatures generated of each node for this time unit
-		for (j = 0; j < size; j++) {
-			pthread_mutex_lock(&infraredValueMutex); // lock with mutex
-			value = simulatedValues[i].values[j];
-			pthread_mutex_unlock(&infraredValueMutex);
-			fprintf(fptr, "values[%d] = %d\n", j, value);
+int isWithinThreshold(NodeInfo* reportingNode, Alert* alert, SatelliteAlert* satelliteAlert) {
+	/**
+	 * Returns true if the reporting node's temperature matches with the simulated temperature by a threshold value and false otherwise
+	 */
+	
+	int cell = reportingNode->coord[0] * cols + reportingNode->coord[1];
+	int infraredTemperature;
+	long frame, timestamp;
+
+	// Only the frames still in the history can be read
+	long end = __atomic_load_n(&satelliteHistory.header->framesCount, __ATOMIC_ACQUIRE);
+	long first = end > satelliteHistory.depth? end - satelliteHistory.depth: 0;
+
+	// Skip to the first frame within the time window of the alert
+	frame = findFrame(&satelliteHistory, first, end, alert->timestamp - TIME_WINDOW);
+	if (frame == end && end > first) 
+		readFrameValue(&satelliteHistory, end - 1, -1, &satelliteAlert->satelliteTime, NULL);
+
+	// Go through the frames within the time window
+	for (; frame < end; frame++) {
+		if (!readFrameValue(&satelliteHistory, frame, cell, &timestamp, &infraredTemperature)) continue; // overwritten meanwhile
+		satelliteAlert->satelliteTime = timestamp;
+		if (timestamp > alert->timestamp + TIME_WINDOW) break;
+		satelliteAlert->satelliteTemperature = infraredTemperature;
+			
+		// Checks if the node's temperature matches the simulated temperature by a threshold
+		if (abs(infraredTemperature - reportingNode->temperature) <= TOLERANCE) {
+			return 1;
 		}
 	}
+	return 0;
 }
 
 
@@ -304,42 +563,50 @@ void* threadSimulation(void* arg) {
 	 */
 	
 	int size = *((int*) arg);
-	int value, i, j, count = 0;
-	time_t rawTime; 
-
-	FILE *fptr = fopen("thread_log.txt", "w");
+	long count = 0;
 
 	// Keep running infinitely
 	while (1) {
-		
-		// Go through all time units 
-		for (i = 0; i < TIME_UNITS; i++) {
-			time(&rawTime); 
-			pthread_mutex_lock(&infraredTimeMutex); // lock with mutex
-			simulatedValues[i].timestamp = rawTime;
-			pthread_mutex_unlock(&infraredTimeMutex);
-
-			// Simulates a temperature for this time unit
-			for (j = 0; j < size; j++) {
-				value = getRandomNumber(j, count);
-				pthread_mutex_lock(&infraredValueMutex); // lock with mutex
-				simulatedValues[i].values[j] = value;
-				pthread_mutex_unlock(&infraredValueMutex);
-			}
+		// Simulate the frame, whole before the thread can be cancelled
+		pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+		simulateFrame(count, size);
+		pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
-			// Sleep for 500 milliseconds 
-			usleep(500000); 
-			
-			// Log the simulated values
-			printSimulatedValues(fptr, size);
-		}
+		// Sleep until the next frame
+		advanceClock(frameInterval);
 
-		// Increase the iteration count (for seeding random value)
+		// Increase the frame count
 		count++;
 	}
 	return NULL;
 }
 
+
+void simulateFrame(long frame, int size) {
+	/**
+	 * Simulates the temperatures of a frame, every frame drawing from its own iteration of the satellite stream, 
+	 * then publishes it to the history and records it if asked
+	 */
+
+	long timestamp = getSimulatedTime(frame * frameInterval);
+
+	fillRandomNumbers(RNG_STREAM_SATELLITE, frame, frameValues, size);
+	publishFrame(&satelliteHistory, timestamp, frameValues);
+	if (recordPrefix != NULL) 
+		writeRecord(&frameRecord, timestamp, frameValues, size, size);
+}
+
+
+void simulateFramesUntil(long timestamp) {
+	/**
+	 * Simulates the frames of the virtual clock up to the timestamp, that have not been yet
+	 */
+
+	long frame = satelliteHistory.header->framesCount;
+	while (getSimulatedTime(frame * frameInterval) <= timestamp) 
+		simulateFrame(frame++, satelliteHistory.size);
+}
+
 void* checkStop(void* arg) {
 	/**
 	 * Waits for the user to stop the program manually 
@@ -367,20 +634,38 @@ void constructInfrared(int size) {
 	 * Initializes and construct the infrared simulation 
 	 */
 	
-	int i;
-
-	// Initializes mutex to access time and temperature
-	pthread_mutex_init(&infraredTimeMutex, NULL);
-	pthread_mutex_init(&infraredValueMutex, NULL);
-	
-	// Initializes global array to store simulated values
-	simulatedValues = (SatelliteData*) malloc(TIME_UNITS * sizeof(SatelliteData)); 
-		
-	// Preset the simulation values 
-	for (i = 0; i < TIME_UNITS; i++) {
-		simulatedValues[i].timestamp = 0;
-		simulatedValues[i].values = (int*) calloc(size, sizeof(int));
+	// Initializes the history of simulated frames in a ring file, which outlives the run for inspection
+	if (initSatelliteHistory(&satelliteHistory, historyFile, rows, cols, historyDepth, frameInterval) != 0) {
+		printf("ERROR: cannot create the satellite ring file %s\n", historyFile);
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
+
+	// Generate each frame privately before publishing it
+	frameValues = (int*) malloc(size * sizeof(int));
+}
+
+
+void replayFrames(int size) {
+	/**
+	 * Constructs the infrared simulation with every frame of the recording, deep enough to keep them all
+	 */
+
+	RecordFile record;
+	long timestamp;
+
+	if (openReplay(&record, replayPrefix, RECORD_FRAMES, size) != 0) 
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	randomSeed = record.header.seed;
+	if (record.samplesCount > historyDepth) 
+		historyDepth = (int) record.samplesCount;
+	constructInfrared(size);
+
+	while (readRecord(&record, &timestamp, frameValues, size, size)) 
+		publishFrame(&satelliteHistory, timestamp, frameValues);
+	printf("Base replaying %ld satellite frames\n", record.samplesCount);
+	fflush(stdout);
+
+	closeRecord(&record);
 }
 
 
@@ -389,12 +674,8 @@ void destructInfrared() {
 	 * Destructs all dynamically allocated memory for infrared simulation
 	 */
 	
-	int i;
-	
-	for (i = 0; i < TIME_UNITS; i++) {
-		free(simulatedValues[i].values);
-	}
-	free(simulatedValues);
+	freeSatelliteHistory(&satelliteHistory);
+	free(frameValues);
 }
 
 
@@ -3,11 +3,9 @@
 
 #include <pthread.h>
 
-// Define SatelliteData structure, to store the information for simulating temperature values
-typedef struct {
-	long timestamp;
-	int* values;
-} SatelliteData; 
+#include "./histogram.h"
+#include "./cluster.h"
+#include "./satellite.h"
 
 // Define SatelliteAlert structure, to store the satellite information matched
 typedef struct {
@@ -15,15 +13,52 @@ typedef struct {
 	int satelliteTemperature;
 } SatelliteAlert;
 
+// Define ReportStatistics structure, to store the running statistics of the reports processed.
+// Communication times are counted in nanoseconds in histograms, overall, per neighbour count and per reporting rank,
+// where a rank's histogram is only allocated once it reports. The reports are also clustered into events
+typedef struct {
+	double totalCommTime;
+	int trueAlertsCount;
+	int falseAlertsCount;
+	double listenTime;
+	Histogram commTimes;
+	Histogram neighboursCommTimes[MAX_NEIGHBOURS + 1];
+	Histogram** rankCommTimes;
+	int ranksCount;
+	EventClusters clusters;
+} ReportStatistics;
+
+// Addresses of the nodes, received at start up
+extern NodeAddress* nodeAddresses;
+
+// Offsets of the nodes' clocks from the base station's, measured at start up
+extern double* clockOffsets;
+
+// Defined in logger.h
+struct ReportLogger;
+struct ReportRecord;
+
 // Function definitions for base.c
 void base(MPI_Comm commWorld, MPI_Comm comm); 
-void receiveMACAndIPAddress(MPI_Comm commWorld, int cartSize);
-void listenForReports(MPI_Comm commWorld);
+void receiveAddresses(MPI_Comm commWorld);
+void drainAggregators(MPI_Comm commWorld);
+void listenForReports(MPI_Comm commWorld, ReportStatistics* statistics);
+int processMessage(MPI_Comm commWorld, char* messageBuffer, int tag, int count, ReportStatistics* statistics, struct ReportLogger* logger);
+int processFixedReport(struct ReportRecord* record, int count, ReportStatistics* statistics, struct ReportLogger* logger);
+int processNodeMessage(MPI_Comm commWorld, char* messageBuffer, int count, ReportStatistics* statistics, struct ReportLogger* logger);
+void processReport(MPI_Comm commWorld, char* reportBuffer, int count, ReportStatistics* statistics, struct ReportLogger* logger);
+void validateReport(struct ReportRecord* record, ReportStatistics* statistics, struct ReportLogger* logger);
+void initReportStatistics(ReportStatistics* statistics, int ranksCount);
+void freeReportStatistics(ReportStatistics* statistics);
+void recordCommTime(ReportStatistics* statistics, int reportingRank, int neighboursCount, double commTime);
+void printCommTimePercentiles(FILE* fptr, Histogram* histogram);
 int isWithinThreshold(NodeInfo* reportingNode, Alert* alert, SatelliteAlert* satelliteAlert);
-void printSimulatedValues(FILE* fptr, int size);
 void* threadSimulation(void* arg);
+void simulateFrame(long frame, int size);
+void simulateFramesUntil(long timestamp);
 void* checkStop(void* arg);
 void constructInfrared(int size);
+void replayFrames(int size);
 void destructInfrared();
 
 #endif
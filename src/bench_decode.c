@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "./init.h"
+#include "./report.h"
+
+// Define microbenchmark constants
+#define BENCH_DECODE_SECONDS 1.0 // time spent decoding reports with each path
+#define BENCH_DECODE_REPORTS 1024 // distinct reports decoded in turn, like a base station ring
+
+
+double getSeconds() {
+	/**
+	 * Returns a monotonic time in seconds
+	 */
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+double measureDecodeTime(int fixed, char (*buffers)[REPORT_BUFFER_SIZE]) {
+	/**
+	 * Decodes the reports in turn for BENCH_DECODE_SECONDS and returns the nanoseconds per report
+	 */
+
+	long decoded = 0, neighboursCount = 0;
+	double startTime = getSeconds(), elapsed;
+	Alert alert;
+	NodeInfo reportingNode;
+	NodeInfo neighboursNodeInfo[MAX_NEIGHBOURS];
+
+	do {
+		char* buffer = buffers[decoded % BENCH_DECODE_REPORTS];
+		if (fixed) neighboursCount += decodeFixedReport(buffer, &alert, &reportingNode, neighboursNodeInfo);
+		else neighboursCount += unpackReport(MPI_COMM_WORLD, buffer, &alert, &reportingNode, neighboursNodeInfo);
+		decoded++;
+		if (decoded % BENCH_DECODE_REPORTS == 0) elapsed = getSeconds() - startTime;
+	} while (decoded % BENCH_DECODE_REPORTS != 0 || elapsed < BENCH_DECODE_SECONDS);
+
+	// Keep the decoded fields alive
+	if (neighboursCount < 0) printf("%d %d\n", reportingNode.rank, neighboursNodeInfo[0].rank);
+	return elapsed * 1e9 / decoded;
+}
+
+
+int main(int argc, char* argv[]) {
+	/**
+	 * Measures the cost per report of decoding a packed report with MPI_Unpack and of reading a fixed-size report
+	 */
+
+	int i, j, position;
+	MPI_Init(&argc, &argv);
+	initAlertType(&AlertType);
+	initNodeInfoType(&NodeInfoType);
+	initReportType(&ReportType);
+	rows = cols = 32;
+
+	char (*packedBuffers)[REPORT_BUFFER_SIZE] = (char (*)[REPORT_BUFFER_SIZE]) malloc(BENCH_DECODE_REPORTS * sizeof(*packedBuffers));
+	char (*fixedBuffers)[REPORT_BUFFER_SIZE] = (char (*)[REPORT_BUFFER_SIZE]) malloc(BENCH_DECODE_REPORTS * sizeof(*fixedBuffers));
+
+	// Build the reports of sensors over the grid, as the nodes would send them
+	for (i = 0; i < BENCH_DECODE_REPORTS; i++) {
+		Report report;
+		memset(&report, 0, sizeof(report));
+		report.alert.timestamp = time(NULL);
+		report.alert.matchCount = 2 + i % 3;
+		report.alert.commStartTime = i;
+		report.reportingNode = (NodeInfo) {i, {i / cols, i % cols}, MIN_TEMP + i % (MAX_TEMP - MIN_TEMP)};
+		report.neighboursCount = 2 + i % 3;
+		for (j = 0; j < report.neighboursCount; j++) 
+			report.neighboursNodeInfo[j] = (NodeInfo) {i + j, {i / cols, j}, THRESHOLD + j};
+
+		position = 0;
+		MPI_Pack(&report.alert, 1, AlertType, packedBuffers[i], REPORT_BUFFER_SIZE, &position, MPI_COMM_WORLD);
+		MPI_Pack(&report.reportingNode, 1, NodeInfoType, packedBuffers[i], REPORT_BUFFER_SIZE, &position, MPI_COMM_WORLD);
+		MPI_Pack(&report.neighboursCount, 1, MPI_INT, packedBuffers[i], REPORT_BUFFER_SIZE, &position, MPI_COMM_WORLD);
+		for (j = 0; j < report.neighboursCount; j++) 
+			MPI_Pack(&report.neighboursNodeInfo[j], 1, NodeInfoType, packedBuffers[i], REPORT_BUFFER_SIZE, &position, MPI_COMM_WORLD);
+
+		// The fixed-size report is received through its datatype exactly as it is laid out
+		MPI_Sendrecv(&report, 1, ReportType, 0, REPORT_TAG, fixedBuffers[i], 1, ReportType, 0, REPORT_TAG, MPI_COMM_SELF, MPI_STATUS_IGNORE);
+	}
+
+	// Both paths must give the same report
+	for (i = 0; i < BENCH_DECODE_REPORTS; i++) {
+		Alert packedAlert, fixedAlert;
+		NodeInfo packedNodes[MAX_NEIGHBOURS + 1], fixedNodes[MAX_NEIGHBOURS + 1];
+		int packedCount = unpackReport(MPI_COMM_WORLD, packedBuffers[i], &packedAlert, &packedNodes[0], &packedNodes[1]);
+		int fixedCount = decodeFixedReport(fixedBuffers[i], &fixedAlert, &fixedNodes[0], &fixedNodes[1]);
+		if (packedCount != fixedCount || packedAlert.matchCount != fixedAlert.matchCount || packedAlert.commStartTime != fixedAlert.commStartTime 
+			|| memcmp(packedNodes, fixedNodes, (packedCount + 1) * sizeof(NodeInfo)) != 0) {
+			printf("ERROR: report %d decodes differently\n", i);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+
+	printf("RESULT reports=%d packed_ns_per_report=%.1f fixed_ns_per_report=%.1f\n", BENCH_DECODE_REPORTS, 
+		measureDecodeTime(0, packedBuffers), measureDecodeTime(1, fixedBuffers));
+	fflush(stdout);
+
+	free(packedBuffers);
+	free(fixedBuffers);
+	MPI_Type_free(&ReportType);
+	MPI_Finalize();
+	return 0;
+}
@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "./init.h"
+#include "./rng.h"
+
+// Define microbenchmark constants
+#define BENCH_FRAMES_SECONDS 1.0 // time spent generating frames of each size with each kernel
+
+
+double getSeconds() {
+	/**
+	 * Returns a monotonic time in seconds
+	 */
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+
+double measureCellsPerSecond(int vector, int* values, int size) {
+	/**
+	 * Generates frames of the given size for BENCH_FRAMES_SECONDS and returns the cells generated per second
+	 */
+
+	int frame = 0;
+	double startTime = getSeconds(), elapsed;
+
+	do {
+		if (vector) fillRandomNumbers(RNG_STREAM_SATELLITE, frame, values, size);
+		else fillRandomNumbersScalar(RNG_STREAM_SATELLITE, frame, values, 0, size);
+		frame++;
+		elapsed = getSeconds() - startTime;
+	} while (elapsed < BENCH_FRAMES_SECONDS);
+	return (double) frame * size / elapsed;
+}
+
+
+int main(int argc, char* argv[]) {
+	/**
+	 * Measures the satellite frame generation rate of the scalar and AVX2 kernels over growing grids
+	 */
+
+	int sizes[] = {25, 10000, 1000000, 16000000};
+	int i, j, size;
+	randomSeed = argc > 1? strtoull(argv[1], NULL, 0): 1;
+
+	printf("Frame kernel: %s\n", hasVectorRandomNumbers()? "avx2": "scalar (avx2 not supported)");
+	for (i = 0; i < (int) (sizeof(sizes) / sizeof(sizes[0])); i++) {
+		size = sizes[i];
+		int* scalarValues = (int*) malloc(size * sizeof(int));
+		int* vectorValues = (int*) malloc(size * sizeof(int));
+
+		// Both kernels must give the same frame
+		fillRandomNumbersScalar(RNG_STREAM_SATELLITE, 0, scalarValues, 0, size);
+		fillRandomNumbers(RNG_STREAM_SATELLITE, 0, vectorValues, size);
+		for (j = 0; j < size && scalarValues[j] == vectorValues[j]; j++);
+		if (j < size) {
+			printf("ERROR: kernels differ at cell %d of a %d cell frame (%d != %d)\n", j, size, scalarValues[j], vectorValues[j]);
+			return 1;
+		}
+
+		printf("RESULT cells=%d scalar_cells_per_s=%.3e frame_cells_per_s=%.3e\n", size, 
+			measureCellsPerSecond(0, scalarValues, size), measureCellsPerSecond(1, vectorValues, size));
+		fflush(stdout);
+		free(scalarValues);
+		free(vectorValues);
+	}
+	return 0;
+}
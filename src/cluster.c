@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "./init.h"
+#include "./cluster.h"
+
+
+void initEventClusters(EventClusters* clusters, int sensorsCount, FILE* fptr) {
+	/**
+	 * Initializes the clusters of a grid of sensors, none of which is in a cluster yet, writing the events to the file
+	 */
+
+	int i;
+
+	clusters->sensorsCount = sensorsCount;
+	clusters->parent = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->next = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->cell = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->size = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->reportsCount = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->trueAlertsCount = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->maxTemperature = (int*) malloc(sensorsCount * sizeof(int));
+	clusters->firstTime = (long*) malloc(sensorsCount * sizeof(long));
+	clusters->lastTime = (long*) malloc(sensorsCount * sizeof(long));
+	clusters->touchTime = (long*) malloc(sensorsCount * sizeof(long));
+	for (i = 0; i < sensorsCount; i++) 
+		clusters->parent[i] = -1;
+
+	clusters->queueCapacity = CLUSTER_QUEUE_CAPACITY;
+	clusters->queue = (ClusterTouch*) malloc(clusters->queueCapacity * sizeof(ClusterTouch));
+	clusters->queueHead = 0;
+	clusters->queueTail = 0;
+	clusters->currentTime = 0;
+	clusters->eventsCount = 0;
+	clusters->clusteredReportsCount = 0;
+	clusters->fptr = fptr;
+}
+
+
+void freeEventClusters(EventClusters* clusters) {
+	/**
+	 * Emits the events of the clusters still open and frees the clusters
+	 */
+
+	int root;
+
+	// The queue holds every open cluster, in the order they were reported
+	while (clusters->queueHead < clusters->queueTail) {
+		root = clusters->queue[clusters->queueHead++ % clusters->queueCapacity].root;
+		if (clusters->parent[root] == root) 
+			emitEvent(clusters, root);
+	}
+
+	free(clusters->parent);
+	free(clusters->next);
+	free(clusters->cell);
+	free(clusters->size);
+	free(clusters->reportsCount);
+	free(clusters->trueAlertsCount);
+	free(clusters->maxTemperature);
+	free(clusters->firstTime);
+	free(clusters->lastTime);
+	free(clusters->touchTime);
+	free(clusters->queue);
+}
+
+
+int findCluster(EventClusters* clusters, int sensor) {
+	/**
+	 * Returns the root of the cluster of a sensor, halving the path to it on the way, or -1 if it is in no cluster
+	 */
+
+	int* parent = clusters->parent;
+
+	if (parent[sensor] < 0) return -1;
+	while (parent[sensor] != sensor) {
+		parent[sensor] = parent[parent[sensor]];
+		sensor = parent[sensor];
+	}
+	return sensor;
+}
+
+
+int mergeClusters(EventClusters* clusters, int first, int second) {
+	/**
+	 * Merges two clusters by their roots, the smaller under the larger, and returns the root of the merged cluster
+	 */
+
+	int swap;
+
+	if (first == second) return first;
+	if (clusters->size[first] < clusters->size[second]) {
+		swap = first;
+		first = second;
+		second = swap;
+	}
+
+	clusters->parent[second] = first;
+	clusters->size[first] += clusters->size[second];
+	clusters->reportsCount[first] += clusters->reportsCount[second];
+	clusters->trueAlertsCount[first] += clusters->trueAlertsCount[second];
+	if (clusters->maxTemperature[second] > clusters->maxTemperature[first]) 
+		clusters->maxTemperature[first] = clusters->maxTemperature[second];
+	if (clusters->firstTime[second] < clusters->firstTime[first]) 
+		clusters->firstTime[first] = clusters->firstTime[second];
+	if (clusters->lastTime[second] > clusters->lastTime[first]) 
+		clusters->lastTime[first] = clusters->lastTime[second];
+
+	// Splice the two circular lists of sensors into one
+	swap = clusters->next[first];
+	clusters->next[first] = clusters->next[second];
+	clusters->next[second] = swap;
+	return first;
+}
+
+
+void addToClusters(EventClusters* clusters, int sensor, int cell, long timestamp, int temperature, int trueAlert, NodeInfo* neighboursNodeInfo, int neighboursCount) {
+	/**
+	 * Adds the report of a sensor from a grid cell to its cluster, merging it with the clusters of its reporting neighbours 
+	 * within TIME_WINDOW seconds, after emitting the events of the clusters that have expired
+	 */
+
+	int i, root, neighbourRoot;
+
+	// Expire the clusters last reported more than TIME_WINDOW seconds ago
+	if (timestamp > clusters->currentTime) 
+		clusters->currentTime = timestamp;
+	expireClusters(clusters, clusters->currentTime - TIME_WINDOW);
+
+	// Start a cluster of its own for a sensor in none
+	root = findCluster(clusters, sensor);
+	if (root < 0) {
+		root = sensor;
+		clusters->parent[sensor] = sensor;
+		clusters->next[sensor] = sensor;
+		clusters->cell[sensor] = cell;
+		clusters->size[sensor] = 1;
+		clusters->reportsCount[sensor] = 0;
+		clusters->trueAlertsCount[sensor] = 0;
+		clusters->maxTemperature[sensor] = temperature;
+		clusters->firstTime[sensor] = timestamp;
+		clusters->lastTime[sensor] = timestamp;
+	}
+
+	clusters->reportsCount[root]++;
+	clusters->trueAlertsCount[root] += trueAlert;
+	if (temperature > clusters->maxTemperature[root]) 
+		clusters->maxTemperature[root] = temperature;
+	if (timestamp < clusters->firstTime[root]) 
+		clusters->firstTime[root] = timestamp;
+	if (timestamp > clusters->lastTime[root]) 
+		clusters->lastTime[root] = timestamp;
+
+	// The neighbours in a cluster have reported within the window, so the same fire spans them
+	for (i = 0; i < neighboursCount; i++) {
+		neighbourRoot = findCluster(clusters, neighboursNodeInfo[i].rank);
+		if (neighbourRoot >= 0) 
+			root = mergeClusters(clusters, root, neighbourRoot);
+	}
+
+	touchCluster(clusters, root);
+	clusters->clusteredReportsCount++;
+}
+
+
+void touchCluster(EventClusters* clusters, int root) {
+	/**
+	 * Queues the current time as the last report of a cluster, growing the queue if it is full
+	 */
+
+	long i, count = clusters->queueTail - clusters->queueHead;
+
+	if (count == clusters->queueCapacity) {
+		ClusterTouch* queue = (ClusterTouch*) malloc(2 * clusters->queueCapacity * sizeof(ClusterTouch));
+		for (i = 0; i < count; i++) 
+			queue[i] = clusters->queue[(clusters->queueHead + i) % clusters->queueCapacity];
+		free(clusters->queue);
+		clusters->queue = queue;
+		clusters->queueCapacity *= 2;
+		clusters->queueHead = 0;
+		clusters->queueTail = count;
+	}
+
+	// The cluster expires with its latest entry, the earlier ones are skipped
+	clusters->queue[clusters->queueTail % clusters->queueCapacity] = (ClusterTouch) {root, clusters->currentTime};
+	clusters->queueTail++;
+	clusters->touchTime[root] = clusters->currentTime;
+}
+
+
+void expireClusters(EventClusters* clusters, long before) {
+	/**
+	 * Emits the events of the clusters last reported before the given time, from the head of the queue
+	 */
+
+	ClusterTouch* touch;
+
+	while (clusters->queueHead < clusters->queueTail) {
+		touch = &clusters->queue[clusters->queueHead % clusters->queueCapacity];
+		if (touch->time >= before) break;
+		clusters->queueHead++;
+
+		// Skip the clusters merged into another, expired already, or touched again since
+		if (clusters->parent[touch->root] != touch->root || clusters->touchTime[touch->root] != touch->time) continue;
+		emitEvent(clusters, touch->root);
+	}
+}
+
+
+void emitEvent(EventClusters* clusters, int root) {
+	/**
+	 * Writes the event of a cluster with its contributing sensors, and takes them out of the cluster
+	 */
+
+	int sensor, next;
+	char firstTime[32], lastTime[32];
+	time_t time;
+	struct tm localTime;
+
+	time = (time_t) clusters->firstTime[root];
+	strftime(firstTime, sizeof(firstTime), "%a %Y-%m-%d %H:%M:%S", localtime_r(&time, &localTime));
+	time = (time_t) clusters->lastTime[root];
+	strftime(lastTime, sizeof(lastTime), "%H:%M:%S", localtime_r(&time, &localTime));
+
+	fprintf(clusters->fptr, "Event %ld: %s to %s, %d sensors, %d reports (%d true alerts), max temperature %d\n", clusters->eventsCount, firstTime, lastTime, 
+		clusters->size[root], clusters->reportsCount[root], clusters->trueAlertsCount[root], clusters->maxTemperature[root]);
+	fprintf(clusters->fptr, "\tSensors:");
+
+	// Walk the circular list once, clearing each sensor
+	sensor = root;
+	do {
+		next = clusters->next[sensor];
+		fprintf(clusters->fptr, " %d (%d, %d)", sensor, clusters->cell[sensor] / cols, clusters->cell[sensor] % cols);
+		clusters->parent[sensor] = -1;
+		clusters->next[sensor] = sensor;
+		sensor = next;
+	} while (sensor != root);
+	fprintf(clusters->fptr, "\n");
+
+	clusters->eventsCount++;
+}
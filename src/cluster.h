@@ -0,0 +1,55 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include <stdio.h>
+
+// Define cluster constants
+#define CLUSTER_QUEUE_CAPACITY 1024 // initial capacity of the expiry queue, doubled whenever it fills
+
+
+// Define ClusterTouch structure, to store when a cluster was last reported, in the order clusters are reported
+typedef struct {
+	int root;
+	long time;
+} ClusterTouch;
+
+// Define EventClusters structure, to merge the reports of adjacent sensors within TIME_WINDOW seconds into one event.
+// The sensors of a cluster form a union-find tree over the rows x cols grid, with -1 as the parent of a sensor in no 
+// cluster, and a circular list through next so the cluster can be listed and cleared when it expires. Each sensor keeps 
+// the grid cell of its coordinates, the one it reported from, to list the event by. The per-cluster 
+// counts are kept at the root. Every report queues the time it touched its cluster, so the clusters expire in order 
+// from the head of the queue, skipping the entries of clusters touched since (a later touchTime) or merged into another
+typedef struct {
+	int sensorsCount;
+	int* parent;
+	int* next;
+	int* cell;
+	int* size;
+	int* reportsCount;
+	int* trueAlertsCount;
+	int* maxTemperature;
+	long* firstTime;
+	long* lastTime;
+	long* touchTime;
+	ClusterTouch* queue;
+	long queueHead;
+	long queueTail;
+	long queueCapacity;
+	long currentTime;
+	long eventsCount;
+	long clusteredReportsCount;
+	FILE* fptr;
+} EventClusters;
+
+
+// Function definitions for cluster.c
+void initEventClusters(EventClusters* clusters, int sensorsCount, FILE* fptr);
+void freeEventClusters(EventClusters* clusters);
+int findCluster(EventClusters* clusters, int sensor);
+int mergeClusters(EventClusters* clusters, int first, int second);
+void addToClusters(EventClusters* clusters, int sensor, int cell, long timestamp, int temperature, int trueAlert, NodeInfo* neighboursNodeInfo, int neighboursCount);
+void touchCluster(EventClusters* clusters, int root);
+void expireClusters(EventClusters* clusters, long before);
+void emitEvent(EventClusters* clusters, int root);
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "./init.h"
+#include "./deployment.h"
+
+
+int loadPositions(char* path, SensorPosition* positions, int count) {
+	/**
+	 * Reads the positions of the sensors from a text file, one "x y" pair per line in the order of the sensors' ranks, 
+	 * skipping blank lines and those starting with #. Returns 0 if it holds exactly count positions, or -1 otherwise
+	 */
+
+	char line[POSITIONS_LINE_SIZE];
+	int loaded = 0;
+	double x, y;
+
+	FILE* fptr = fopen(path, "r");
+	if (fptr == NULL) {
+		printf("ERROR: cannot open the positions file %s\n", path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fptr) != NULL) {
+		if (line[strspn(line, " \t\r\n")] == '\0' || line[strspn(line, " \t")] == '#') continue;
+		if (sscanf(line, "%lf %lf", &x, &y) != 2 || loaded == count) {
+			printf("ERROR: %s must hold one \"x y\" position for each of the %d sensors\n", path, count);
+			fclose(fptr);
+			return -1;
+		}
+		positions[loaded].x = x;
+		positions[loaded].y = y;
+		loaded++;
+	}
+	fclose(fptr);
+
+	if (loaded != count) {
+		printf("ERROR: %s holds %d positions for %d sensors\n", path, loaded, count);
+		return -1;
+	}
+	return 0;
+}
+
+
+void buildSpatialIndex(SpatialIndex* index, SensorPosition* positions, int count, double cellSize) {
+	/**
+	 * Builds the uniform grid hash of the positions, its cells being cellSize wide from the lowest position
+	 */
+
+	int i;
+
+	index->positions = positions;
+	index->sensorsCount = count;
+	index->cellSize = cellSize;
+	index->originX = index->originY = 0;
+	for (i = 0; i < count; i++) {
+		if (i == 0 || positions[i].x < index->originX) index->originX = positions[i].x;
+		if (i == 0 || positions[i].y < index->originY) index->originY = positions[i].y;
+	}
+
+	// Sort the sensors by the cell they fall in
+	index->entries = (CellEntry*) malloc(count * sizeof(CellEntry));
+	for (i = 0; i < count; i++) {
+		index->entries[i].row = (long) floor((positions[i].y - index->originY) / cellSize);
+		index->entries[i].col = (long) floor((positions[i].x - index->originX) / cellSize);
+		index->entries[i].sensor = i;
+	}
+	qsort(index->entries, count, sizeof(CellEntry), compareCellEntries);
+}
+
+
+void freeSpatialIndex(SpatialIndex* index) {
+	/**
+	 * Frees the cells of the spatial index
+	 */
+
+	free(index->entries);
+}
+
+
+int compareCellEntries(const void* a, const void* b) {
+	/**
+	 * Orders the entries by cell row, then column, then sensor
+	 */
+
+	const CellEntry* first = (const CellEntry*) a;
+	const CellEntry* second = (const CellEntry*) b;
+
+	if (first->row != second->row) return first->row < second->row? -1: 1;
+	if (first->col != second->col) return first->col < second->col? -1: 1;
+	return first->sensor - second->sensor;
+}
+
+
+int findNearestInRange(SpatialIndex* index, int sensor, double range, int* nearest, int maxCount) {
+	/**
+	 * Finds up to maxCount other sensors within range of the sensor, the nearest first (the lower rank first at 
+	 * equal distances), and returns how many were found
+	 */
+
+	int i, low, high, middle, count = 0;
+	long dRow, dCol;
+	double dx, dy, distance, distances[maxCount];
+	CellEntry cell;
+	SensorPosition* position = &index->positions[sensor];
+
+	long row = (long) floor((position->y - index->originY) / index->cellSize);
+	long col = (long) floor((position->x - index->originX) / index->cellSize);
+
+	// Range is no wider than a cell, so only the sensors of the 3 x 3 cells around the sensor's can be in range
+	for (dRow = -1; dRow <= 1; dRow++) {
+		for (dCol = -1; dCol <= 1; dCol++) {
+			// Binary search the first entry of the cell
+			cell.row = row + dRow;
+			cell.col = col + dCol;
+			cell.sensor = -1;
+			low = 0;
+			high = index->sensorsCount;
+			while (low < high) {
+				middle = low + (high - low) / 2;
+				if (compareCellEntries(&index->entries[middle], &cell) < 0) low = middle + 1;
+				else high = middle;
+			}
+
+			// Keep the sensors of the cell within range, in order of distance
+			for (; low < index->sensorsCount && index->entries[low].row == cell.row && index->entries[low].col == cell.col; low++) {
+				int other = index->entries[low].sensor;
+				if (other == sensor) continue;
+				dx = index->positions[other].x - position->x;
+				dy = index->positions[other].y - position->y;
+				distance = dx * dx + dy * dy;
+				if (distance > range * range) continue;
+
+				// Insert it among the nearest found so far, dropping the farthest if they are full
+				for (i = count; i > 0 && (distances[i - 1] > distance || (distances[i - 1] == distance && nearest[i - 1] > other)); i--) {
+					if (i < maxCount) {
+						distances[i] = distances[i - 1];
+						nearest[i] = nearest[i - 1];
+					}
+				}
+				if (i < maxCount) {
+					distances[i] = distance;
+					nearest[i] = other;
+					if (count < maxCount) count++;
+				}
+			}
+		}
+	}
+	return count;
+}
+
+
+int buildRadioGraph(SensorPosition* positions, int count, double range, int* offsets, int* links) {
+	/**
+	 * Links each pair of sensors within range of each other that are both among the MAX_NEIGHBOURS nearest of the other, 
+	 * so every sensor has at most MAX_NEIGHBOURS neighbours, and both ends of a link know of it. The neighbours of sensor i 
+	 * are written to links[offsets[i]] to links[offsets[i + 1] - 1], nearest first, and the number of links is returned
+	 */
+
+	int i, j, k, linksCount = 0;
+	SpatialIndex index;
+
+	// Find the nearest sensors in range of every sensor
+	int* nearest = (int*) malloc((long) count * MAX_NEIGHBOURS * sizeof(int));
+	int* nearestCounts = (int*) malloc(count * sizeof(int));
+	buildSpatialIndex(&index, positions, count, range);
+	for (i = 0; i < count; i++) 
+		nearestCounts[i] = findNearestInRange(&index, i, range, &nearest[(long) i * MAX_NEIGHBOURS], MAX_NEIGHBOURS);
+	freeSpatialIndex(&index);
+
+	// Keep the links both ends agree on
+	for (i = 0; i < count; i++) {
+		offsets[i] = linksCount;
+		for (k = 0; k < nearestCounts[i]; k++) {
+			int other = nearest[(long) i * MAX_NEIGHBOURS + k];
+			for (j = 0; j < nearestCounts[other] && nearest[(long) other * MAX_NEIGHBOURS + j] != i; j++);
+			if (j < nearestCounts[other]) 
+				links[linksCount++] = other;
+		}
+	}
+	offsets[count] = linksCount;
+
+	free(nearest);
+	free(nearestCounts);
+	return linksCount;
+}
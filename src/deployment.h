@@ -0,0 +1,44 @@
+#ifndef DEPLOYMENT_H
+#define DEPLOYMENT_H
+
+// Define deployment constants
+#define RADIO_RANGE 1.0 // default radio range, within which sensors at integer grid positions link to their 4 cartesian neighbours
+#define POSITIONS_LINE_SIZE 256
+
+
+// Define SensorPosition structure, to store where a sensor is deployed
+typedef struct {
+	double x;
+	double y;
+} SensorPosition;
+
+// Define CellEntry structure, to store a sensor under the cell of the spatial index its position falls in
+typedef struct {
+	long row;
+	long col;
+	int sensor;
+} CellEntry;
+
+// Define SpatialIndex structure, a uniform grid hash of cells as wide as the radio range over the sensors' positions.
+// The sensors are sorted by cell, so the sensors of a cell are a contiguous run found by binary search, and the sensors 
+// within range of a sensor are among those of its cell and the 8 around it. Building it takes O(N log N) for the sort, 
+// and a lookup O(log N) plus the sensors of the 9 cells, so only sensors close to each other are ever compared
+typedef struct {
+	SensorPosition* positions;
+	int sensorsCount;
+	double cellSize;
+	double originX;
+	double originY;
+	CellEntry* entries;
+} SpatialIndex;
+
+
+// Function definitions for deployment.c
+int loadPositions(char* path, SensorPosition* positions, int count);
+void buildSpatialIndex(SpatialIndex* index, SensorPosition* positions, int count, double cellSize);
+void freeSpatialIndex(SpatialIndex* index);
+int compareCellEntries(const void* a, const void* b);
+int findNearestInRange(SpatialIndex* index, int sensor, double range, int* nearest, int maxCount);
+int buildRadioGraph(SensorPosition* positions, int count, double range, int* offsets, int* links);
+
+#endif
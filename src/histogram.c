@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+
+#include "./histogram.h"
+
+
+void initHistogram(Histogram* histogram, int precision) {
+	/**
+	 * Initializes an empty histogram covering 0 to HISTOGRAM_HIGHEST_VALUE with the given sub-bucket bits
+	 */
+
+	histogram->precision = precision;
+	histogram->size = getHistogramIndex(precision, HISTOGRAM_HIGHEST_VALUE) + 1;
+	histogram->counts = (int*) calloc(histogram->size, sizeof(int));
+	histogram->totalCount = 0;
+	histogram->maxValue = 0;
+}
+
+
+void freeHistogram(Histogram* histogram) {
+	/**
+	 * Frees the buckets of a histogram
+	 */
+
+	free(histogram->counts);
+	histogram->counts = NULL;
+}
+
+
+long long getValueAtPercentile(Histogram* histogram, double percentile) {
+	/**
+	 * Returns the highest value of the bucket holding the given percentile (0 to 100), or the exact maximum for 100
+	 */
+
+	int index, shift, halfBuckets = 1 << (histogram->precision - 1);
+	long count = 0;
+	long long highestValue;
+
+	if (histogram->totalCount == 0) return 0;
+
+	// The rank of the value at the percentile, at least the first value
+	long target = (long) (percentile / 100 * histogram->totalCount + 0.5);
+	if (target < 1) target = 1;
+	if (target >= histogram->totalCount) return histogram->maxValue;
+
+	for (index = 0; index < histogram->size; index++) {
+		count += histogram->counts[index];
+		if (count >= target) break;
+	}
+
+	// Invert the bucket index to the highest value it counts
+	shift = index / halfBuckets - 1;
+	if (shift < 0) shift = 0;
+	highestValue = ((long long) (index - (shift << (histogram->precision - 1))) << shift) + ((1LL << shift) - 1);
+	return highestValue < histogram->maxValue? highestValue: histogram->maxValue;
+}
+
+
+void reduceHistogram(Histogram* histogram, Histogram* result, int root, MPI_Comm comm) {
+	/**
+	 * Merges the histograms of the same precision of every process in the communicator into the result at the root
+	 */
+
+	MPI_Reduce(histogram->counts, result->counts, histogram->size, MPI_INT, MPI_SUM, root, comm);
+	MPI_Reduce(&histogram->totalCount, &result->totalCount, 1, MPI_LONG, MPI_SUM, root, comm);
+	MPI_Reduce(&histogram->maxValue, &result->maxValue, 1, MPI_LONG_LONG, MPI_MAX, root, comm);
+}
@@ -0,0 +1,52 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+// Define histogram constants
+#define HISTOGRAM_PRECISION 6 // sub-bucket bits of the overall histograms, values are kept within 1/32 (about 3%)
+#define HISTOGRAM_RANK_PRECISION 4 // sub-bucket bits of the per-rank histograms, values are kept within 1/8 (about 12%)
+#define HISTOGRAM_HIGHEST_VALUE (1LL << 40) // highest value recorded (in nanoseconds, about 18 minutes), higher values are clamped
+
+
+// Define Histogram structure, a fixed-memory log-linear (HDR-style) histogram of non-negative integer values.
+// Values below 2^precision are counted exactly, above that every power of two is split into 2^(precision-1) linear sub-buckets
+typedef struct {
+	int precision;
+	int size;
+	int* counts;
+	long totalCount;
+	long long maxValue;
+} Histogram;
+
+
+// Function definitions for histogram.c
+void initHistogram(Histogram* histogram, int precision);
+void freeHistogram(Histogram* histogram);
+long long getValueAtPercentile(Histogram* histogram, double percentile);
+void reduceHistogram(Histogram* histogram, Histogram* result, int root, MPI_Comm comm);
+
+
+static inline int getHistogramIndex(int precision, long long value) {
+	/**
+	 * Returns the index of the bucket counting the value
+	 */
+
+	int magnitude = 63 - __builtin_clzll(value | 1);
+	int shift = magnitude - (precision - 1);
+	if (shift < 0) shift = 0;
+	return (shift << (precision - 1)) + (int) (value >> shift);
+}
+
+
+static inline void recordValue(Histogram* histogram, long long value) {
+	/**
+	 * Counts a value in constant time
+	 */
+
+	if (value < 0) value = 0;
+	if (value > HISTOGRAM_HIGHEST_VALUE) value = HISTOGRAM_HIGHEST_VALUE;
+	histogram->counts[getHistogramIndex(histogram->precision, value)]++;
+	histogram->totalCount++;
+	if (value > histogram->maxValue) histogram->maxValue = value;
+}
+
+#endif
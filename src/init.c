@@ -3,43 +3,92 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <getopt.h>
+#include <limits.h>
+#include <sys/resource.h>
 
 
 #include "./init.h"
+#include "./report.h"
+#include "./satellite.h"
+#include "./simclock.h"
+#include "./deployment.h"
 #include "./node.h"
 #include "./base.h"
+#include "./tile.h"
+#include "./aggregator.h"
+#include "mac_ip.c"
 
 
 int main(int argc, char *argv[]) {
 	/**
 	 * Main program 
 	 */
-	int rank, size, color;
+	int rank, size, color, regionColor, provided;
 	MPI_Comm newComm;
 
-	// Initialize MPI
-	MPI_Init(&argc, &argv);
+	// Open MPI spins inside blocking waits, let it yield the core while nothing arrives unless told otherwise
+	setenv("OMPI_MCA_mpi_yield_when_idle", "1", 0);
+
+	// Initialize MPI, only the main thread of each process makes MPI calls
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 	MPI_Comm_size(MPI_COMM_WORLD, &size);
 
+	// Parse command line options
+	int argsIndex = parseOptions(argc, argv);
+	if (argsIndex < 0) {
+		if (rank == 0) printUsage();
+		MPI_Finalize();
+		return 0;
+	}
+	if (workerThreads > 0 && provided < MPI_THREAD_FUNNELED) {
+		if (rank == 0) printf("ERROR: the MPI library does not support threads, run without --threads\n");
+		MPI_Finalize();
+		return 0;
+	}
+
+	// The node ranks follow the base station, and the aggregators take the last ranks
+	nodesCount = size - 1 - aggregatorsCount;
+	if (nodesCount < 1) {
+		if (rank == 0) {
+			printf("ERROR: %d processes leave no node ranks beside the base station and %d aggregators\n", size, aggregatorsCount);
+			printUsage();
+		}
+		MPI_Finalize();
+		return 0;
+	}
+
 	// Parse command line arguments
-	if (argc == 3) {
-		rows = atoi(argv[1]);
-		cols = atoi(argv[2]);
+	if (argc - argsIndex == 2) {
+		rows = atoi(argv[argsIndex]);
+		cols = atoi(argv[argsIndex + 1]);
 		
-		// Output error message if size given is not the same
-		if ((rows*cols) != size-1) {
+		// Output error message if size given is not the same, tiled mode only needs a tile grid of the node ranks
+		if (tiledMode && (rows <= 0 || cols <= 0 || getTileGrid(nodesCount, tileGrid) < 0)) {
 			if (rank == 0) {
-				printf("ERROR: (rows * cols) + 1 = (%d * %d) + 1 = %d != %d\n", rows, cols, (rows*cols)+1, size);
-				printf("HELPER: mpirun -np <no-of-processes> --oversubscribe wsn <rows> <cols>\n");
+				printf("ERROR: %d node ranks cannot be arranged into tiles of a (%d x %d) grid\n", nodesCount, rows, cols);
+				printUsage();
+			}
+			MPI_Finalize();
+			return 0;
+		}
+		if (!tiledMode && (rows*cols) != nodesCount) {
+			if (rank == 0) {
+				printf("ERROR: (rows * cols) + %d = (%d * %d) + %d = %d != %d\n", 1 + aggregatorsCount, rows, cols, 1 + aggregatorsCount, (rows*cols) + 1 + aggregatorsCount, size);
+				printUsage();
 			}
 			MPI_Finalize();
 			return 0;
 		}	
+		if (!tiledMode) {
+			tileGrid[0] = rows;
+			tileGrid[1] = cols;
+		}
 	} else {
 		if (rank == 0) {
 			printf("NOTE: No rows and cols provided, please provide rows and cols.\n");
-			printf("HELPER: mpirun -np <no-of-processes> --oversubscribe wsn <rows> <cols>\n");
+			printUsage();
 		}
 		MPI_Finalize();
 		return 0;
@@ -48,22 +97,38 @@ int main(int argc, char *argv[]) {
 	// Get inputs from user
 	getUserInputs(MPI_COMM_WORLD, rank, size);
 
-	// Split the sensor nodes (into color 0) and base station (into color 1)
-	color = (rank == 0);
+	// Split the sensor nodes (into color 0), base station (into color 1) and aggregators (into color 2)
+	color = (rank == 0)? 1: (rank > nodesCount)? 2: 0;
 	MPI_Comm_split(MPI_COMM_WORLD, color, 0, &newComm);
 
+	// Split each aggregator with the nodes of its region, the aggregator taking rank 0 to receive their reports
+	reportComm = MPI_COMM_WORLD;
+	if (aggregatorsCount > 0) {
+		regionColor = (rank == 0)? MPI_UNDEFINED: (rank > nodesCount)? rank - nodesCount - 1: getNodeRegion(rank - 1);
+		MPI_Comm_split(MPI_COMM_WORLD, regionColor, (rank > nodesCount)? 0: rank, &reportComm);
+	}
+
+	// Duplicate the world for the termination broadcast, which every rank posts at start up and completes at the end
+	MPI_Comm_dup(MPI_COMM_WORLD, &terminationComm);
+
 	// Initialize MPI Datatypes
 	initAlertType(&AlertType);
 	initNodeInfoType(&NodeInfoType);
+	initReportType(&ReportType);
 
 	// Execute the base or node function respectively
 	if (rank == 0) {
 		base(MPI_COMM_WORLD, newComm);
+	} else if (rank > nodesCount) {
+		aggregator(MPI_COMM_WORLD, newComm);
+	} else if (tiledMode) {
+		tile(MPI_COMM_WORLD, newComm);
 	} else {
 		node(MPI_COMM_WORLD, newComm);
 	}
 
-	// Finalize the MPI program
+	// Finalize the MPI program, once the base station has the addresses
+	MPI_Wait(&addressesRequest, MPI_STATUS_IGNORE);
 	MPI_Finalize();
 	return 0;
 	
@@ -81,6 +146,229 @@ void printGuide() {
 	printf("===========================================================================\n");
 
 }
+
+
+void printUsage() {
+	printf("HELPER: mpirun -np <no-of-processes> --oversubscribe wsn [options] <rows> <cols>\n");
+	printf("OPTIONS:\n");
+	printf("\t--benchmark\t\t\trun headless and print a machine-readable RESULT line\n");
+	printf("\t--node-interval <seconds>\tduration of each iteration for the sensor nodes, may be 0 (default: 0.5)\n");
+	printf("\t--base-interval <seconds>\tduration of each iteration for the base station, may be 0 (default: 1.0)\n");
+	printf("\t--iterations <count>\t\tnumber of reports the base station processes (default: 20)\n");
+	printf("\t--duration <seconds>\t\tstop listening for reports after this long, 0 for no limit (default: 0)\n");
+	printf("\t--exchange <request|persistent|rma>\tneighbour temperature exchange protocol (default: persistent)\n");
+	printf("\t--report-ring <slots>\t\tnumber of report receives kept posted by the base station, 0 to receive one at a time (default: %d)\n", REPORT_RING_SIZE);
+	printf("\t--frame-interval <seconds>\tduration of each satellite frame, may be 0 (default: 0.5)\n");
+	printf("\t--tiled\t\t\t\teach node rank simulates a tile of the <rows> x <cols> sensors, for any number of processes\n");
+	printf("\t--threads <count>\t\tworker threads simulating the sensors of each tile, 0 to simulate them on the MPI thread (default: 0)\n");
+	printf("\t--aggregators <count>\t\textra ranks batching the reports of a band of grid rows each before the base station (default: 0)\n");
+	printf("\t--report-format <fixed|packed|compact>\twire format of the reports: fixed-size structs, MPI_Pack-ed, or the alerts of a node coalesced into one message (default: fixed)\n");
+	printf("\t--coalesce-count <alerts>\tcompact alerts a node holds before sending them, at most %d (default: %d)\n", COMPACT_MAX_ALERTS, COALESCE_COUNT);
+	printf("\t--coalesce-window <seconds>\tlongest a node holds a compact alert before sending it (default: %.1f)\n", COALESCE_WINDOW);
+	printf("\t--history <frames>\t\tsatellite frames kept for validating reports, 1 byte per sensor per frame of disk (default: %d)\n", TIME_UNITS);
+	printf("\t--history-file <path>\t\tring file the satellite frames are kept in, to inspect with satview (default: %s)\n", SATELLITE_FILE);
+	printf("\t--record <prefix>\t\trecord every node reading and satellite frame into <prefix>_node_<rank>.bin and <prefix>_frames.bin\n");
+	printf("\t--replay <prefix>\t\treplay a recording of the same grid and processes without sleeps, until every reading is reported, not with --exchange request\n");
+	printf("\t--virtual-time <seconds>\trun this many simulated seconds on a virtual clock, without sleeps, then stop, not with --exchange request (default: 0, the wall clock)\n");
+	printf("\t--positions <file>\t\tlink the sensors by radio range from their \"x y\" positions, one line per node rank, instead of the grid\n");
+	printf("\t--radio-range <distance>\tdistance within which the sensors of --positions are linked, to their %d nearest at most (default: %.1f)\n", MAX_NEIGHBOURS, RADIO_RANGE);
+	printf("\t--seed <number>\t\t\tseed of the simulated temperatures, the same seed reproduces the same temperatures (default: current time)\n");
+}
+
+
+int parseOptions(int argc, char* argv[]) {
+	/**
+	 * Parses the command line options into the global configuration and returns the index of the first positional argument, or -1 on an invalid option
+	 */
+
+	static struct option longOptions[] = {
+		{"benchmark", no_argument, NULL, 'b'},
+		{"node-interval", required_argument, NULL, 'n'},
+		{"base-interval", required_argument, NULL, 'i'},
+		{"iterations", required_argument, NULL, 'c'},
+		{"duration", required_argument, NULL, 'd'},
+		{"exchange", required_argument, NULL, 'e'},
+		{"report-ring", required_argument, NULL, 'r'},
+		{"seed", required_argument, NULL, 's'},
+		{"frame-interval", required_argument, NULL, 'f'},
+		{"tiled", no_argument, NULL, 't'},
+		{"threads", required_argument, NULL, 'p'},
+		{"aggregators", required_argument, NULL, 'a'},
+		{"report-format", required_argument, NULL, 'o'},
+		{"coalesce-count", required_argument, NULL, 'k'},
+		{"coalesce-window", required_argument, NULL, 'w'},
+		{"history", required_argument, NULL, 'y'},
+		{"history-file", required_argument, NULL, 'h'},
+		{"record", required_argument, NULL, 'R'},
+		{"replay", required_argument, NULL, 'P'},
+		{"virtual-time", required_argument, NULL, 'v'},
+		{"positions", required_argument, NULL, 'x'},
+		{"radio-range", required_argument, NULL, 'g'},
+		{NULL, 0, NULL, 0}
+	};
+	int option;
+
+	// Use the default values
+	nodeInterval = 0.5;
+	baseInterval = 1.0;
+	baseIterationsCount = 20;
+	duration = 0;
+	benchmarkMode = 0;
+	inputsProvided = 0;
+	exchangeMode = EXCHANGE_PERSISTENT;
+	reportRingSize = REPORT_RING_SIZE;
+	randomSeed = (unsigned long long) time(NULL);
+	frameInterval = 0.5;
+	tiledMode = 0;
+	workerThreads = 0;
+	aggregatorsCount = 0;
+	reportFormat = REPORT_FIXED;
+	coalesceCount = COALESCE_COUNT;
+	coalesceWindow = COALESCE_WINDOW;
+	historyDepth = TIME_UNITS;
+	historyFile = SATELLITE_FILE;
+	recordPrefix = NULL;
+	replayPrefix = NULL;
+	virtualHorizon = 0;
+	positionsFile = NULL;
+	radioRange = RADIO_RANGE;
+	clockStartTime = (long) time(NULL);
+	finiteRun = 0;
+
+	// Let the base station report errors through the usage message only
+	opterr = 0;
+	while ((option = getopt_long(argc, argv, "", longOptions, NULL)) != -1) {
+		switch (option) {
+			case 'b':
+				benchmarkMode = 1;
+				inputsProvided = 1;
+				break;
+			case 'n':
+				nodeInterval = atof(optarg);
+				inputsProvided = 1;
+				if (nodeInterval < 0) return -1;
+				break;
+			case 'i':
+				baseInterval = atof(optarg);
+				inputsProvided = 1;
+				if (baseInterval < 0) return -1;
+				break;
+			case 'c':
+				baseIterationsCount = atoi(optarg);
+				inputsProvided = 1;
+				if (baseIterationsCount <= 0) return -1;
+				break;
+			case 'd':
+				duration = atof(optarg);
+				inputsProvided = 1;
+				if (duration < 0) return -1;
+				break;
+			case 'e':
+				if (strcmp(optarg, "request") == 0) exchangeMode = EXCHANGE_REQUEST;
+				else if (strcmp(optarg, "persistent") == 0) exchangeMode = EXCHANGE_PERSISTENT;
+				else if (strcmp(optarg, "rma") == 0) exchangeMode = EXCHANGE_RMA;
+				else return -1;
+				break;
+			case 'r':
+				reportRingSize = atoi(optarg);
+				if (reportRingSize < 0) return -1;
+				break;
+			case 's':
+				randomSeed = strtoull(optarg, NULL, 0);
+				break;
+			case 't':
+				tiledMode = 1;
+				break;
+			case 'a':
+				aggregatorsCount = atoi(optarg);
+				if (aggregatorsCount < 0) return -1;
+				break;
+			case 'p':
+				workerThreads = atoi(optarg);
+				if (workerThreads < 0) return -1;
+				break;
+			case 'f':
+				frameInterval = atof(optarg);
+				if (frameInterval < 0) return -1;
+				break;
+			case 'o':
+				if (strcmp(optarg, "fixed") == 0) reportFormat = REPORT_FIXED;
+				else if (strcmp(optarg, "packed") == 0) reportFormat = REPORT_PACKED;
+				else if (strcmp(optarg, "compact") == 0) reportFormat = REPORT_COMPACT;
+				else return -1;
+				break;
+			case 'k':
+				coalesceCount = atoi(optarg);
+				if (coalesceCount < 1 || coalesceCount > COMPACT_MAX_ALERTS) return -1;
+				break;
+			case 'w':
+				coalesceWindow = atof(optarg);
+				if (coalesceWindow < 0) return -1;
+				break;
+			case 'y':
+				historyDepth = atoi(optarg);
+				if (historyDepth < 1) return -1;
+				break;
+			case 'h':
+				historyFile = optarg;
+				break;
+			case 'R':
+				recordPrefix = optarg;
+				break;
+			case 'P':
+				replayPrefix = optarg;
+				break;
+			case 'v':
+				virtualHorizon = atof(optarg);
+				// Must be positive
+				if (virtualHorizon <= 0) return -1;
+				break;
+			case 'x':
+				positionsFile = optarg;
+				break;
+			case 'g':
+				radioRange = atof(optarg);
+				// Must be positive
+				if (radioRange <= 0) return -1;
+				break;
+			default:
+				return -1;
+		}
+	}
+
+	// The worker threads share the sensors of a tile
+	if (workerThreads > 0 && !tiledMode) return -1;
+
+	// An irregular deployment has one sensor per node rank, and its neighbours are not the grid directions compact reports encode
+	if (positionsFile != NULL && (tiledMode || reportFormat == REPORT_COMPACT)) return -1;
+
+	// A replay runs every recorded reading through without sleeps, until every node is done. Only the exchanges that 
+	// compare the readings of the same epoch replay the same reports, not a request answered with the current reading
+	if (replayPrefix != NULL) {
+		if (recordPrefix != NULL || exchangeMode == EXCHANGE_REQUEST) return -1;
+		nodeInterval = 0;
+		baseInterval = 0;
+		frameInterval = 0;
+		duration = 0;
+		baseIterationsCount = INT_MAX;
+		inputsProvided = 1;
+		finiteRun = 1;
+	}
+
+	// The virtual clock runs the nodes to the horizon without sleeps, stepping time by the intervals, so they cannot be 0.
+	// The base station keeps enough frames for the reports of nodes running apart by up to VIRTUAL_SYNC_INTERVAL, and 
+	// only the exchanges that compare the readings of the same epoch keep the reports those nodes make apart ordered
+	if (virtualHorizon > 0) {
+		if (replayPrefix != NULL || nodeInterval <= 0 || frameInterval <= 0 || exchangeMode == EXCHANGE_REQUEST) return -1;
+		duration = 0;
+		baseIterationsCount = INT_MAX;
+		inputsProvided = 1;
+		finiteRun = 1;
+		if (historyDepth < VIRTUAL_HISTORY_WINDOWS * TIME_WINDOW / frameInterval + 1) 
+			historyDepth = (int) (VIRTUAL_HISTORY_WINDOWS * TIME_WINDOW / frameInterval) + 1;
+	}
+	return optind;
+}
 	
 
 void getUserInputs(MPI_Comm commWorld, int rank, int size) {
@@ -90,24 +378,29 @@ void getUserInputs(MPI_Comm commWorld, int rank, int size) {
 	
 	int baseRank = 0;
 	
-	// let base station to get input from user 
+	// let base station to get input from user, unless they were given as options
 	if (rank == baseRank) {
 		// Print program guide
-		printGuide();
+		if (!benchmarkMode) printGuide();
 
-		// Gets response
-		char response;
-		printf("Creating a grid size of (%d x %d) using rank 0 to rank %d\n", rows, cols, size-2);
+		printf("Creating a grid size of (%d x %d) using rank 0 to rank %d\n", rows, cols, nodesCount-1);
+		if (tiledMode) printf("Simulating the sensors in (%d x %d) tiles, one per rank\n", tileGrid[0], tileGrid[1]);
+		if (aggregatorsCount > 0) printf("Batching reports with %d aggregators using rank %d to rank %d\n", aggregatorsCount, nodesCount + 1, size-1);
+		if (workerThreads > 0) printf("Simulating the sensors of each tile with %d worker threads\n", workerThreads);
 		fflush(stdout);
 
 		printf("Creating base station using rank %d\n", size-1);
 		fflush(stdout);
+	}
 
+	if (rank == baseRank && !inputsProvided) {
+		// Gets response
+		char response;
 		printf("Do you want to provide simulation inputs or use default values? (y/n): ");
 		fflush(stdout);
 
 		fflush(stdin);
-		scanf("%s",&response);
+		scanf(" %c", &response);
 
 		if (response == 'y') {
 			// Get the duration of each interval for node
@@ -128,18 +421,26 @@ void getUserInputs(MPI_Comm commWorld, int rank, int size) {
 			printf("How many iterations (integer) does the base station run? (eg: 10, 20, etc): ");
 			fflush(stdout);			
 			scanf("%d", &baseIterationsCount);
-
-		} else {
-			// Use default values
-			nodeInterval = 0.5;
-			baseInterval = 1.0;
-			baseIterationsCount = 20;
 		}
+	}
 
+	if (rank == baseRank) {
 		printf("Summary:\n");
 		printf("Iteration interval for sensor nodes: %.2fs\n", nodeInterval);
 		printf("Iteration interval for base station: %.2fs\n", baseInterval);
-		printf("Total number of iterations to be run: %d\n", baseIterationsCount);
+		if (!finiteRun) printf("Total number of iterations to be run: %d\n", baseIterationsCount);
+		if (duration > 0) printf("Listening for reports for at most: %.2fs\n", duration);
+		printf("Neighbour temperature exchange: %s\n", getExchangeModeName(exchangeMode));
+		printf("Report receives posted by base station: %d\n", reportRingSize);
+		if (reportFormat == REPORT_COMPACT) printf("Compact reports coalescing up to %d alerts for at most %.3fs\n", coalesceCount, coalesceWindow);
+		else printf("%s reports, one per alert\n", reportFormat == REPORT_FIXED? "Fixed-size": "Packed");
+		printf("Satellite frame interval: %.3fs\n", frameInterval);
+		printf("Satellite history: %d frames in %s (%.1f MB)\n", historyDepth, historyFile, (double) getSatelliteFileSize(historyDepth, rows * cols) / (1 << 20));
+		printf("Random seed: %llu\n", randomSeed);
+		if (recordPrefix != NULL) printf("Recording the node readings and satellite frames into %s_*.bin\n", recordPrefix);
+		if (replayPrefix != NULL) printf("Replaying the node readings and satellite frames of %s_*.bin without sleeps\n", replayPrefix);
+		if (positionsFile != NULL) printf("Irregular deployment of %s, linked within a radio range of %.2f\n", positionsFile, radioRange);
+		if (virtualHorizon > 0) printf("Running %.1f simulated seconds on the virtual clock, without sleeps\n", virtualHorizon);
 		printf("Program will now start running...\n");
 		printf("===========================================================================\n");
 		fflush(stdout);
@@ -149,57 +450,162 @@ void getUserInputs(MPI_Comm commWorld, int rank, int size) {
 	MPI_Bcast(&nodeInterval, 1, MPI_FLOAT, baseRank, commWorld);
 	MPI_Bcast(&baseIterationsCount, 1, MPI_INT, baseRank, commWorld);
 	MPI_Bcast(&baseInterval, 1, MPI_FLOAT, baseRank, commWorld);
+	MPI_Bcast(&randomSeed, 1, MPI_UNSIGNED_LONG_LONG, baseRank, commWorld);
+	MPI_Bcast(&clockStartTime, 1, MPI_LONG, baseRank, commWorld);
 
 	// Wait for all processes to complete
 	MPI_Barrier(MPI_COMM_WORLD);
 }
 
  
-void initAlertType(MPI_Datatype* AlertType) {
+void getResourceUsage(double* cpuTime, long* contextSwitches) {
 	/**
-	 * Initializes MPI datatype for Alert struct
-	 */	
-	
-	int alertBlockLen[3] = {1, 1, 1};
-	MPI_Datatype alertTypes[3] = {MPI_LONG, MPI_INT, MPI_DOUBLE};
-	MPI_Aint alertDisp[3];
+	 * Gets the CPU time (user and system, in seconds) and the number of context switches of this process so far
+	 */
 
-	alertDisp[0] = offsetof(Alert, timestamp);
-	alertDisp[1] = offsetof(Alert, matchCount);
-	alertDisp[2] = offsetof(Alert, commStartTime);
-	
-	MPI_Type_create_struct(3, alertBlockLen, alertDisp, alertTypes, AlertType);
-	MPI_Type_commit(AlertType);
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	*cpuTime = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+	*contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
 }
 
 
-void initNodeInfoType(MPI_Datatype* NodeInfoType) {
+void reportResourceUsage(MPI_Comm comm, char* role, long sensorsCount) {
 	/**
-	 * Initializes MPI datatype for NodeInfo struct
+	 * Sums the resource usage of all processes in the communicator, each simulating the given number of sensors, 
+	 * and prints the CPU time per process and the CPU time and context switches per sensor
 	 */
-	
-	int nodeInfoBlockLen[3] = {1, 2, 1};
-	MPI_Datatype nodeInfoTypes[5] = {MPI_INT, MPI_INT, MPI_INT};
-	MPI_Aint nodeInfoDisp[3];
 
-	nodeInfoDisp[0] = offsetof(NodeInfo, rank);
-	nodeInfoDisp[1] = offsetof(NodeInfo, coord);
-	nodeInfoDisp[2] = offsetof(NodeInfo, temperature);
+	int rank, size;
+	double cpuTime, totalCPUTime, longestCPUTime;
+	long contextSwitches, totalContextSwitches, totalSensorsCount;
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	getResourceUsage(&cpuTime, &contextSwitches);
+
+	MPI_Reduce(&cpuTime, &totalCPUTime, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+	MPI_Reduce(&cpuTime, &longestCPUTime, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+	MPI_Reduce(&contextSwitches, &totalContextSwitches, 1, MPI_LONG, MPI_SUM, 0, comm);
+	MPI_Reduce(&sensorsCount, &totalSensorsCount, 1, MPI_LONG, MPI_SUM, 0, comm);
+
+	if (rank == 0) {
+		printf("%s CPU (%d processes): %.3f s total, %.3f s average, %.3f s longest, %ld context switches\n", 
+			role, size, totalCPUTime, totalCPUTime / size, longestCPUTime, totalContextSwitches);
+		if (totalSensorsCount > 0) 
+			printf("%s CPU per sensor (%ld sensors): %.6f s, %.3f context switches\n", 
+				role, totalSensorsCount, totalCPUTime / totalSensorsCount, (double) totalContextSwitches / totalSensorsCount);
+		fflush(stdout);
+	}
+}
+
+
+double sumCPUTime(MPI_Comm commWorld) {
+	/**
+	 * Sums the CPU time of every process into the base station, every process must call it once at the end
+	 */
 
-	MPI_Type_create_struct(3, nodeInfoBlockLen, nodeInfoDisp, nodeInfoTypes, NodeInfoType);
-	MPI_Type_commit(NodeInfoType);
+	double cpuTime, totalCPUTime = 0;
+	long contextSwitches;
+
+	getResourceUsage(&cpuTime, &contextSwitches);
+	MPI_Reduce(&cpuTime, &totalCPUTime, 1, MPI_DOUBLE, MPI_SUM, 0, commWorld);
+	return totalCPUTime;
 }
 
 
-int getRandomNumber(int rank, int count) {
+double* synchronizeClocks(MPI_Comm commWorld) {
 	/**
-	 * Returns a random number 
+	 * Estimates the offset of every process's MPI_Wtime clock from the base station's, so times taken on a node 
+	 * can be compared with times taken on the base. Every process must call it once at start up, the offsets 
+	 * (base clock minus process clock, indexed by rank) are returned at the base station only
 	 */
-	
-	unsigned int seed = (unsigned) (time(NULL) ^ (rank + count)); 
-	return (rand_r(&seed) % (MAX_TEMP - MIN_TEMP + 1)) + MIN_TEMP;
+
+	int rank, size, i, found, *isGlobal;
+	double now, *clockTimes = NULL, *clockOffsets = NULL;
+
+	MPI_Comm_rank(commWorld, &rank);
+	MPI_Comm_size(commWorld, &size);
+	if (rank == 0) {
+		clockTimes = (double*) malloc(size * sizeof(double));
+		clockOffsets = (double*) calloc(size, sizeof(double));
+	}
+
+	// Read the clocks as every process leaves the same barrier, accurate to the barrier's exit skew
+	MPI_Barrier(commWorld);
+	now = MPI_Wtime();
+	MPI_Gather(&now, 1, MPI_DOUBLE, clockTimes, 1, MPI_DOUBLE, 0, commWorld);
+
+	// Clocks that are already synchronized need no offset
+	MPI_Comm_get_attr(commWorld, MPI_WTIME_IS_GLOBAL, &isGlobal, &found);
+	if (rank == 0) {
+		if (!found || !*isGlobal) {
+			for (i = 0; i < size; i++) 
+				clockOffsets[i] = clockTimes[0] - clockTimes[i];
+		}
+		free(clockTimes);
+	}
+	return clockOffsets;
+}
+
+
+void listenForTermination(int* terminationBuffer, MPI_Request* request) {
+	/**
+	 * Posts this rank's part of the termination broadcast, the request completing once the base station signals termination. 
+	 * Testing it costs no message until then, and the signal reaches all ranks through a tree in O(log N) steps
+	 */
+
+	MPI_Ibcast(terminationBuffer, 1, MPI_INT, 0, terminationComm, request);
 }
 
 
+void broadcastTermination() {
+	/**
+	 * Signals termination to every other rank, from the base station
+	 */
+
+	int terminated = 1;
+	MPI_Request request;
+
+	MPI_Ibcast(&terminated, 1, MPI_INT, 0, terminationComm, &request);
+	MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
 
 
+NodeAddress* gatherAddresses(MPI_Comm commWorld, NodeAddress* address) {
+	/**
+	 * Finds the MAC and IP addresses of this rank's host, querying the interfaces once per host, and gathers 
+	 * the addresses of all ranks to the base station. Every process must call it once at start up, 
+	 * the addresses (indexed by rank) are returned at the base station only. The other ranks go on 
+	 * without waiting for the base station, completing addressesRequest before they finalize
+	 */
+
+	static NodeAddress hostAddress;
+	int rank, size, hostRank;
+	MPI_Comm hostComm;
+	NodeAddress* addresses = NULL;
+
+	MPI_Comm_rank(commWorld, &rank);
+	MPI_Comm_size(commWorld, &size);
+
+	// The lowest rank of each host queries its interfaces for the ranks sharing the host
+	MPI_Comm_split_type(commWorld, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &hostComm);
+	MPI_Comm_rank(hostComm, &hostRank);
+	if (hostRank == 0) {
+		memset(&hostAddress, 0, sizeof(NodeAddress));
+		getMACAddress(hostAddress.macAddress);
+		getIPAddress(hostAddress.ipAddress);
+	}
+	MPI_Bcast(&hostAddress, sizeof(NodeAddress), MPI_CHAR, 0, hostComm);
+	MPI_Comm_free(&hostComm);
+	*address = hostAddress;
+
+	// Gather the fixed-width addresses into one contiguous array at the base station
+	if (rank == 0) 
+		addresses = (NodeAddress*) malloc(size * sizeof(NodeAddress));
+	MPI_Igather(&hostAddress, sizeof(NodeAddress), MPI_CHAR, addresses, sizeof(NodeAddress), MPI_CHAR, 0, commWorld, &addressesRequest);
+	if (rank == 0) 
+		MPI_Wait(&addressesRequest, MPI_STATUS_IGNORE);
+	return addresses;
+}
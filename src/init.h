@@ -3,6 +3,11 @@
 
 #include <mpi.h>
 
+// Define address lengths, with the terminating null
+#define MAC_ADDRESS_LENGTH 18
+#define IP_ADDRESS_LENGTH 16
+
+
 // Create NodeInfo structure to store the information of a node
 typedef struct {
 	int rank;
@@ -19,6 +24,13 @@ typedef struct {
 } Alert;
 
 
+// Define NodeAddress structure, to store the MAC and IP addresses of the host of a rank in fixed-width strings
+typedef struct {
+	char macAddress[MAC_ADDRESS_LENGTH];
+	char ipAddress[IP_ADDRESS_LENGTH];
+} NodeAddress;
+
+
 // Define MPI shfitings
 #define SHIFT_ROW 0
 #define SHIFT_COL 1
@@ -27,45 +39,99 @@ typedef struct {
 
 
 // Define program constants
-#define TIME_UNITS 10 // reduce this to increase more false alert, and vice-versa
+#define TIME_UNITS 10 // default number of satellite frames kept, reduce this to increase more false alert, and vice-versa
 #define TIME_WINDOW 8 // reduce this to increase more false alert, and vice-versa
 #define MAX_TEMP 120
 #define MIN_TEMP 50 
+#define MAX_NEIGHBOURS 4 // left, right, top and bottom neighbours in the grid
 #define THRESHOLD 80 // "high temperature" threshold
 #define TOLERANCE 5 // tolerance range of 5 to be "high temperature"
-#define ADDRESS_BUFFER_SIZE 500
-#define REPORT_BUFFER_SIZE 1000
+#define REPORT_BUFFER_SIZE 4096 // largest report message, a single report or a batch from an aggregator
 #define BUFFER_SIZE 1000
+#define REPORT_RING_SIZE 16 // default number of report receives the base station keeps posted
+#define EXCHANGE_MAX_LAG 8 // epochs a node may run ahead of its slowest neighbour before it waits
+#define BASE_POLL_INTERVAL 1000 // microseconds the base station sleeps between polls when it has a duration to keep
+#define NODE_POLL_INTERVAL 1000 // microseconds a node sleeps between serving its neighbours' requests while an iteration interval passes
 #define NODE_DELAYS 3 // delays the node execution for 3 seconds to allow temperatures to be simulated first
 
 
+// Create Report structure to store a report of an alert in one contiguous block, sent as the fixed-size ReportType
+typedef struct {
+	Alert alert;
+	NodeInfo reportingNode;
+	int neighboursCount;
+	NodeInfo neighboursNodeInfo[MAX_NEIGHBOURS];
+} Report;
+
+
 // Define MPI communication tags
 #define INIT_TAG 0
-#define ADDRESSES_TAG 0
-#define INFO_EXCHANGE_TAG 1
 #define REQUEST_TAG 2
 #define TEMPERATURE_TAG 3
 #define REPORT_TAG 4
-#define TERMINATION_TAG 5
 #define CANCEL_TAG 6
+#define PUBLISH_TAG 7
+#define HALO_TAG 8
+#define REPORT_BATCH_TAG 9
+#define AGGREGATOR_CLOSED_TAG 10
+
+
+// Define neighbour temperature exchange modes
+#define EXCHANGE_REQUEST 0 // request/reply round trip per neighbour whenever a node is hot
+#define EXCHANGE_PERSISTENT 1 // every node publishes its reading to neighbours once per epoch over persistent requests
+#define EXCHANGE_RMA 2 // every node exposes its reading in an RMA window that hot neighbours read without involving it
 
 
 // Global variables
 MPI_Datatype AlertType;
 MPI_Datatype NodeInfoType;
+MPI_Datatype ReportType;
 int rows;
 int cols;
 float nodeInterval;
 float baseInterval;
 int baseIterationsCount;
+float duration;
+float frameInterval;
+int historyDepth;
+char* historyFile;
+char* recordPrefix; // where the node readings and satellite frames are recorded, or NULL
+char* replayPrefix; // where the node readings and satellite frames are replayed from at full speed, or NULL
+float virtualHorizon; // simulated seconds run on the virtual clock, or 0 to run on the wall clock
+char* positionsFile; // positions of the sensors of an irregular deployment, or NULL for the cartesian grid
+float radioRange; // distance within which the sensors of an irregular deployment are linked
+long clockStartTime; // time the simulated clock starts at, the same on every rank
+int finiteRun; // nodes stop by themselves and send an empty report once done, as in a replay or on the virtual clock
+int tiledMode;
+int workerThreads;
+int aggregatorsCount;
+int nodesCount;
+MPI_Comm reportComm; // where nodes send their reports, to rank 0 of it: the base station, or the aggregator of their region
+MPI_Request addressesRequest; // the gather of the addresses to the base station, completed by every rank before it finalizes
+MPI_Comm terminationComm; // where the base station broadcasts the termination signal, apart from every other collective
+int tileGrid[N_DIMS];
+int exchangeMode;
+int reportRingSize;
+int reportFormat;
+int coalesceCount;
+float coalesceWindow;
+int benchmarkMode;
+int inputsProvided;
+unsigned long long randomSeed;
 
 
 // Function definitions for init.c
 void printGuide();
+void printUsage();
+int parseOptions(int argc, char* argv[]);
 void getUserInputs(MPI_Comm commWorld, int rank, int size);
-void initAlertType(MPI_Datatype* AlertType);
-void initNodeInfoType(MPI_Datatype* NodeInfoType);
-int getRandomNumber(int rank, int count);
+void getResourceUsage(double* cpuTime, long* contextSwitches);
+void reportResourceUsage(MPI_Comm comm, char* role, long sensorsCount);
+double sumCPUTime(MPI_Comm commWorld);
+double* synchronizeClocks(MPI_Comm commWorld);
+NodeAddress* gatherAddresses(MPI_Comm commWorld, NodeAddress* address);
+void listenForTermination(int* terminationBuffer, MPI_Request* request);
+void broadcastTermination();
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "./init.h"
+#include "./base.h"
+#include "./logger.h"
+#include "./tile.h"
+
+
+void startReportLogger(ReportLogger* logger, FILE* fptr) {
+	/**
+	 * Initializes the report logger on an opened file and starts its writer thread
+	 */
+
+	int i;
+
+	logger->records = (ReportRecord*) malloc(LOGGER_CAPACITY * sizeof(ReportRecord));
+	logger->buffer = (char*) malloc(LOGGER_BUFFER_SIZE);
+	logger->head = 0;
+	logger->tail = 0;
+	logger->running = 1;
+	logger->fptr = fptr;
+
+	// No time is formatted yet
+	for (i = 0; i < TIME_CACHE_SIZE; i++) 
+		logger->timeCache.times[i] = -1;
+
+	pthread_create(&logger->tid, 0, threadReportLogger, logger);
+}
+
+
+void logReport(ReportLogger* logger, ReportRecord* record) {
+	/**
+	 * Hands a report record to the writer thread, only waiting if the ring is full
+	 */
+
+	unsigned long head = logger->head;
+
+	// Wait for the writer thread to free a slot
+	while (head - __atomic_load_n(&logger->tail, __ATOMIC_ACQUIRE) >= LOGGER_CAPACITY) 
+		usleep(LOGGER_IDLE_SLEEP);
+
+	logger->records[head & (LOGGER_CAPACITY - 1)] = *record;
+	__atomic_store_n(&logger->head, head + 1, __ATOMIC_RELEASE);
+}
+
+
+void stopReportLogger(ReportLogger* logger) {
+	/**
+	 * Waits for the writer thread to write out every record handed to it, the file stays open for the caller
+	 */
+
+	__atomic_store_n(&logger->running, 0, __ATOMIC_RELEASE);
+	pthread_join(logger->tid, NULL);
+
+	free(logger->records);
+	free(logger->buffer);
+}
+
+
+void* threadReportLogger(void* arg) {
+	/**
+	 * Formats the report records in the ring into large blocks and writes them out until the logger is stopped
+	 */
+
+	ReportLogger* logger = (ReportLogger*) arg;
+	unsigned long head, tail = logger->tail;
+	int length = 0;
+
+	while (1) {
+		head = __atomic_load_n(&logger->head, __ATOMIC_ACQUIRE);
+
+		// Write out what is formatted while there is nothing new, and finish once stopped and drained
+		if (tail == head) {
+			if (length > 0) {
+				fwrite(logger->buffer, 1, length, logger->fptr);
+				fflush(logger->fptr);
+				length = 0;
+			}
+			if (!__atomic_load_n(&logger->running, __ATOMIC_ACQUIRE) && __atomic_load_n(&logger->head, __ATOMIC_ACQUIRE) == tail) 
+				break;
+			usleep(LOGGER_IDLE_SLEEP);
+			continue;
+		}
+
+		// Format every available record, writing the block out whenever it is full
+		while (tail != head) {
+			if (length > LOGGER_BUFFER_SIZE - LOGGER_RECORD_SIZE) {
+				fwrite(logger->buffer, 1, length, logger->fptr);
+				length = 0;
+			}
+			length += formatReportRecord(logger, &logger->records[tail & (LOGGER_CAPACITY - 1)], logger->buffer + length);
+			tail++;
+			__atomic_store_n(&logger->tail, tail, __ATOMIC_RELEASE);
+		}
+	}
+	return NULL;
+}
+
+
+int formatReportRecord(ReportLogger* logger, ReportRecord* record, char* buffer) {
+	/**
+	 * Formats a report record into the buffer and returns its length
+	 */
+
+	int i, length = 0;
+	NodeInfo* neighbour;
+
+	length += sprintf(buffer + length, "============================================================\n");
+	length += sprintf(buffer + length, "Iteration: %d\n", record->iteration);
+	length += sprintf(buffer + length, "Logged Time: %s", formatTime(&logger->timeCache, record->loggedTime));
+
+	length += sprintf(buffer + length, "\n");
+	length += sprintf(buffer + length, "Alert Reported Time: %s", formatTime(&logger->timeCache, record->report.alert.timestamp));
+	length += sprintf(buffer + length, "Alert Type: %s\n", record->trueAlert? "True": "False");
+	length += sprintf(buffer + length, "Number of Adjacent Matches to Reporting Node: %d\n", record->report.alert.matchCount);
+	length += sprintf(buffer + length, "Communication Time (seconds): %f\n", record->commTime);
+
+	length += sprintf(buffer + length, "\n");
+	length += sprintf(buffer + length, "Reporting Node Information:\n");
+	length += sprintf(buffer + length, "\t\tRank: %d\n", record->report.reportingNode.rank);
+	length += sprintf(buffer + length, "\t\tCoordinate: (%d, %d)\n", record->report.reportingNode.coord[0], record->report.reportingNode.coord[1]);
+	length += sprintf(buffer + length, "\t\tTemperature: %d\n", record->report.reportingNode.temperature);
+	length += sprintf(buffer + length, "\t\tMAC Address: %s\n", nodeAddresses[getSensorOwner(record->report.reportingNode.rank)].macAddress);
+	length += sprintf(buffer + length, "\t\tIP Address: %s\n", nodeAddresses[getSensorOwner(record->report.reportingNode.rank)].ipAddress);
+
+	length += sprintf(buffer + length, "\n");
+	length += sprintf(buffer + length, "Adjacent Nodes Information:\n");
+	for (i = 0; i < record->report.neighboursCount; i++) {
+		neighbour = &record->report.neighboursNodeInfo[i];
+		length += sprintf(buffer + length, "\t\tRank: %d\n", neighbour->rank);
+		length += sprintf(buffer + length, "\t\tCoordinate: (%d, %d)\n", neighbour->coord[0], neighbour->coord[1]);
+		length += sprintf(buffer + length, "\t\tTemperature: %d\n", neighbour->temperature);
+		length += sprintf(buffer + length, "\t\tMAC Address: %s\n", nodeAddresses[getSensorOwner(neighbour->rank)].macAddress);
+		length += sprintf(buffer + length, "\t\tIP Address: %s\n", nodeAddresses[getSensorOwner(neighbour->rank)].ipAddress);
+		length += sprintf(buffer + length, "\t\t-------------------------\n");
+	}
+
+	length += sprintf(buffer + length, "\n");
+	length += sprintf(buffer + length, "Infrared Satellite Information:\n");
+	length += sprintf(buffer + length, "\t\tReporting Time: %s", formatTime(&logger->timeCache, record->satelliteAlert.satelliteTime));
+	length += sprintf(buffer + length, "\t\tReporting Temperature: %d\n", record->satelliteAlert.satelliteTemperature);
+
+	return length;
+}
+
+
+char* formatTime(TimeCache* timeCache, long timestamp) {
+	/**
+	 * Returns the timestamp formatted as asctime does, converting each second only once while it stays cached
+	 */
+
+	int slot = timestamp & (TIME_CACHE_SIZE - 1);
+	time_t rawTime = timestamp;
+	struct tm timeInfo;
+
+	if (timeCache->times[slot] != timestamp) {
+		asctime_r(localtime_r(&rawTime, &timeInfo), timeCache->strings[slot]);
+		timeCache->times[slot] = timestamp;
+	}
+	return timeCache->strings[slot];
+}
@@ -0,0 +1,50 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <pthread.h>
+
+// Define logger constants
+#define LOGGER_CAPACITY 4096 // number of report records the ring holds, must be a power of two
+#define LOGGER_BUFFER_SIZE (1 << 20) // size of the block the writer thread formats into before writing it out
+#define LOGGER_RECORD_SIZE 4096 // upper bound of the formatted size of one report record
+#define LOGGER_IDLE_SLEEP 1000 // microseconds the writer thread sleeps when the ring is empty
+#define TIME_CACHE_SIZE 4 // number of formatted times cached, must be a power of two
+
+// Define ReportRecord structure, to store everything needed to log a processed report. 
+// The report is kept as it is sent, so fixed-size reports can be received straight into a record
+typedef struct ReportRecord {
+	int iteration;
+	long loggedTime;
+	Report report;
+	int trueAlert;
+	double commTime;
+	SatelliteAlert satelliteAlert;
+} ReportRecord;
+
+// Define TimeCache structure, to store the formatted time of recently logged seconds
+typedef struct {
+	long times[TIME_CACHE_SIZE];
+	char strings[TIME_CACHE_SIZE][32];
+} TimeCache;
+
+// Define ReportLogger structure, a single-producer single-consumer ring of report records drained by a writer thread
+typedef struct ReportLogger {
+	ReportRecord* records;
+	unsigned long head; // next record written by the receiving thread
+	unsigned long tail; // next record formatted by the writer thread
+	int running;
+	FILE* fptr;
+	char* buffer;
+	TimeCache timeCache;
+	pthread_t tid;
+} ReportLogger;
+
+// Function definitions for logger.c
+void startReportLogger(ReportLogger* logger, FILE* fptr);
+void logReport(ReportLogger* logger, ReportRecord* record);
+void stopReportLogger(ReportLogger* logger);
+void* threadReportLogger(void* arg);
+int formatReportRecord(ReportLogger* logger, ReportRecord* record, char* buffer);
+char* formatTime(TimeCache* timeCache, long timestamp);
+
+#endif
@@ -4,10 +4,19 @@
 #include <time.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
+#include <sched.h>
+#include <arpa/inet.h>
+#include <math.h>
 
 #include "./init.h"
 #include "./node.h"
-#include "mac_ip.c"
+#include "./trace.h"
+#include "./rng.h"
+#include "./report.h"
+#include "./record.h"
+#include "./simclock.h"
+#include "./deployment.h"
 
 
 void node(MPI_Comm commWorld, MPI_Comm comm) {
@@ -29,49 +38,52 @@ void node(MPI_Comm commWorld, MPI_Comm comm) {
 	int* neighbours;
 	int neighboursCount;
 
-	// Assign cartesian grid topology 
+	// Assign cartesian grid topology, or the radio graph of the sensors' positions, and get the coordinates
 	MPI_Comm_rank(comm, &rank);
 	MPI_Comm_size(comm, &size);
-	initCartesianTopology(comm, rows, cols, &cartComm);
+	if (positionsFile != NULL) 
+		initDeploymentTopology(comm, positionsFile, radioRange, &cartComm, coord);
+	else {
+		initCartesianTopology(comm, rows, cols, &cartComm);
+		MPI_Cart_coords(cartComm, rank, N_DIMS, coord);
+	}
 	
-	// Get the coordinates and the list of neighboring ranks
-	MPI_Cart_coords(cartComm, rank, N_DIMS, coord);
+	// Get the list of neighboring ranks
 	getValidNeighbours(cartComm, &neighbours, &neighboursCount);
 
-	// Opening a log file
-	char filename[50];
-	sprintf(filename, "log_%d.txt", rank);
-	FILE *fptr = fopen(filename, "w");
+	// Opening a binary trace, decoded into the text log by tracedump
+	TraceBuffer trace;
+	openTrace(&trace, rank);
 
 
 	/*******************************************************
 	 * Set up communication with base station
 	 *******************************************************/
 
-	// Send the MAC and IP addresses to base station with the original communicator
-	int baseRank = 0;
-	sendMACAndIPAddress(fptr, commWorld, baseRank);
+	// Let the base station measure this node's clock offset, to time the reports
+	synchronizeClocks(commWorld);
+
+	// Share the MAC and IP addresses with base station with the original communicator
+	shareAddress(&trace, commWorld);
 	
 
 	/*******************************************************
 	 * Set up NodeInfo struct for communication
 	 *******************************************************/
 
-	// Initialize the basic information of a node
+	// Initialize the basic information of a node, identified by its rank in comm even where the radio graph reordered it
 	NodeInfo nodeInfo;
 	nodeInfo.rank = rank;
 	memcpy(nodeInfo.coord, coord, sizeof(coord));
 	nodeInfo.temperature = 0;
 
-	// Send the content of NodeInfo to all neighbours for future usage
+	// Send the content of NodeInfo to all neighbours for future usage, in one round with all of them
 	NodeInfo* neighboursNodeInfo = (NodeInfo*) malloc(neighboursCount * sizeof(NodeInfo));
-	for (i = 0; i < neighboursCount; i++) {
-		MPI_Sendrecv(&nodeInfo, 1, NodeInfoType, neighbours[i], INFO_EXCHANGE_TAG, &neighboursNodeInfo[i], 1, NodeInfoType, neighbours[i], INFO_EXCHANGE_TAG, cartComm, MPI_STATUS_IGNORE);
-	}	
+	exchangeNodeInfo(cartComm, &nodeInfo, neighboursNodeInfo);
 
 	// Logging neighbours of a node
 	for (i = 0; i < neighboursCount; i++) 
-		fprintf(fptr, "Neighbour Rank: %d, Coord: (%d, %d)\n", neighboursNodeInfo[i].rank, neighboursNodeInfo[i].coord[0], neighboursNodeInfo[i].coord[1]);
+		traceEvent(&trace, TRACE_NEIGHBOUR, neighboursNodeInfo[i].rank, ((long long) neighboursNodeInfo[i].coord[0] << 32) | (unsigned int) neighboursNodeInfo[i].coord[1]);
 
 
 	/*******************************************************
@@ -79,93 +91,164 @@ void node(MPI_Comm commWorld, MPI_Comm comm) {
 	 *******************************************************/
 
 	// Initialize the variables for simulation
-	int terminated, temperature, waiting, allReceived, count; 
-	terminated = 0;
+	int temperature, waiting, count; 
 	count = 0;
 
-	// asynchronous sent for sending to neighbours
-	MPI_Request sendRequests[neighboursCount]; 
-
-	// asynchronous request for receiving from neighbours
-	MPI_Request recvRequests[neighboursCount]; 
+	// Pre-post the receives for neighbours' temperatures, temperature requests and termination
+	NodeExchange exchange;
+	initExchange(&exchange, commWorld, cartComm, neighbours, neighboursCount, neighboursNodeInfo, &trace, rank);
+
+	// Initialize the exchange statistics
+	double waitStartTime = 0;
+	Histogram latencies;
+	initHistogram(&latencies, HISTOGRAM_PRECISION);
+
+	// Initialize the sender coalescing the reports
+	ReportSender sender;
+	initReportSender(&sender, reportComm, 0);
+
+	// Record the readings, or read them back from a recording
+	RecordFile record;
+	long timestamp, replayCount;
+	int iterationsCount = INT_MAX;
+	if (recordPrefix != NULL && openRecord(&record, recordPrefix, rank, 1) != 0) 
+		MPI_Abort(commWorld, 1);
+	if (replayPrefix != NULL) {
+		if (openReplay(&record, replayPrefix, rank, 1) != 0) 
+			MPI_Abort(commWorld, 1);
+
+		// Every node replays as many iterations as the shortest recording, so none waits on a neighbour that is done
+		MPI_Allreduce(&record.samplesCount, &replayCount, 1, MPI_LONG, MPI_MIN, comm);
+		iterationsCount = (int) replayCount;
+	}
 
-	// asynchronous sent for sending temperature to ranks that request for it
-	MPI_Request tempSentReq; 
+	// On the virtual clock, every node runs the iterations up to the horizon, waiting for the others at every synchronization
+	int syncIterations = (int) (VIRTUAL_SYNC_INTERVAL / nodeInterval) + 1;
+	if (isVirtualClock()) 
+		iterationsCount = (int) (virtualHorizon / nodeInterval);
 
 	// Output running message
 	printf("Node %d started executing\n", rank);
 	
-	// Sleep for 3 seconds to wait for infrared simulation to be populated
-	sleep(NODE_DELAYS);
-
-	// Keep running until it receives a termination signal
-	while (!terminated) {
-		waiting = 0;
-		temperature = getRandomNumber(rank, count);
+	// Wait 3 seconds for infrared simulation to be populated, unless the frames are replayed
+	if (replayPrefix == NULL) 
+		advanceClock(NODE_DELAYS);
+
+	// Keep running until it receives a termination signal, or it has replayed every reading or reached the horizon
+	while (!exchange.terminated && count < iterationsCount) {
+		if (isVirtualClock() && count > 0 && count % syncIterations == 0) 
+			waitForNodes(&exchange, comm);
+
+		if (replayPrefix != NULL) 
+			readRecord(&record, &timestamp, &temperature, 1, 1);
+		else {
+			timestamp = getSimulatedTime(NODE_DELAYS + count * nodeInterval);
+			temperature = getRandomNumber(RNG_STREAM_NODE, rank, count);
+			if (recordPrefix != NULL) 
+				writeRecord(&record, timestamp, &temperature, 1, 1);
+		}
+		sender.timestamp = timestamp;
 		nodeInfo.temperature = temperature;
+		exchange.temperature = temperature;
 
 		// Log the temperature
-		fprintf(fptr, "Temperature: %d\n", temperature);
-			
-		// Send a temperature request from all neighbours
-		if (temperature > THRESHOLD) {
-			sendTemperatureRequests(cartComm, neighbours, neighboursCount, neighboursNodeInfo, sendRequests, recvRequests, &waiting, fptr, rank);
-			allReceived = 0;
-		}
-		
-		// Check if any process is requesting for my temperature and send them accordingly 
-		checkTemperatureRequest(cartComm, &tempSentReq, temperature, fptr, rank);
-
-		// Check if base station has sent a termination signal and terminate accordingly
-		checkTermination(commWorld, &terminated, baseRank, fptr, rank);
-		if (terminated) {
-			clearPendingCommunications(neighboursCount, sendRequests, recvRequests, &tempSentReq);
-			continue;
-		}
-
-		// Keep waiting for the neighbours' temperature to be received 
-		while (waiting) {
+		traceEvent(&trace, TRACE_TEMPERATURE, -1, temperature);
 
-			// Check if any process is requesting for my temperature and send them accordingly 
-			checkTemperatureRequest(cartComm, &tempSentReq, temperature, fptr, rank);
+		// Publish the temperature of this epoch to all neighbours, or request theirs if it is hot
+		waiting = (temperature > THRESHOLD);
+		if (exchangeMode == EXCHANGE_PERSISTENT) {
+			advanceEpoch(&exchange, count);
 
-			// Check if base station has sent a termination signal and terminate accordingly
-			checkTermination(commWorld, &terminated, baseRank, fptr, rank);
-			if (terminated) {
-				clearPendingCommunications(neighboursCount, sendRequests, recvRequests, &tempSentReq);
-				waiting = 0; 
+			// Bound how far this node runs ahead of its neighbours so their queues stay short without sleeps
+			while (!exchange.terminated && !hasReceivedAllTemperatures(&exchange, count - EXCHANGE_MAX_LAG)) 
+				processEvents(&exchange, 1);
+			publishTemperature(&exchange, count);
+		}
+		else if (exchangeMode == EXCHANGE_RMA) 
+			exposeReading(&exchange, count);
+		else if (waiting) 
+			sendTemperatureRequests(&exchange);
+		waitStartTime = MPI_Wtime();
+
+		// Read the neighbours' temperatures of this epoch straight from their windows, whatever they are doing
+		if (waiting && exchangeMode == EXCHANGE_RMA) 
+			readNeighbourTemperatures(&exchange, count);
+		
+		// Serve the requests and termination signal that arrived since the last iteration
+		processEvents(&exchange, 0);
+
+		// Block until the neighbours' temperatures are received, serving requests and termination meanwhile
+		while (waiting && !exchange.terminated) {
+			if (!hasReceivedAllTemperatures(&exchange, count)) {
+				// Nothing arrives for a window, so read again the neighbours that have not exposed this epoch yet, 
+				// leaving them the core in between as they are the ones to catch up
+				if (exchangeMode == EXCHANGE_RMA) {
+					processEvents(&exchange, 0);
+					sched_yield();
+					readNeighbourTemperatures(&exchange, count);
+				} else 
+					processEvents(&exchange, 1);
 				continue;
 			}
 
-			// Tests if all neighbouring ranks have sent their temperature to this node
-			MPI_Testall(neighboursCount, recvRequests, &allReceived, MPI_STATUSES_IGNORE);
-			if (allReceived) {
-
-				// Log the receive of temperature
-				for (i = 0; i < neighboursCount; i++) 
-					fprintf(fptr, "Rank %d has received the temperature %d from rank %d\n", rank, neighboursNodeInfo[i].temperature, neighboursNodeInfo[i].rank);
-				
-				// Check matching count
-				int matchCount = getMatchingCount(neighboursNodeInfo, temperature, neighboursCount);
-
-				// Send the report to base station
-				if (matchCount >= 2) {
-					sendReport(commWorld, baseRank, matchCount, &nodeInfo, neighboursNodeInfo, neighboursCount);
-				}
-				waiting = 0;
+			// Record the latency of this detection
+			recordValue(&latencies, (long long) ((MPI_Wtime() - waitStartTime) * 1e9));
+
+			// Log the receive of temperature
+			for (i = 0; i < neighboursCount; i++) 
+				traceEvent(&trace, TRACE_TEMPERATURE_RECEIVED, neighboursNodeInfo[i].rank, neighboursNodeInfo[i].temperature);
+			
+			// Check matching count
+			int matchCount = getMatchingCount(neighboursNodeInfo, temperature, neighboursCount);
+
+			// Send the report to base station
+			if (matchCount >= 2) {
+				submitReport(&sender, matchCount, &nodeInfo, neighboursNodeInfo, neighboursCount);
 			}
+			waiting = 0;
 		}
 
-		// Sleep to create delays in microseconds
-		usleep(nodeInterval * 1e6);
+		if (exchange.terminated) continue;
+
+		// Send the alerts held for the coalescing window
+		flushReports(&sender, 0);
+
+		// Let the iteration interval pass, serving the neighbours' requests meanwhile in request mode
+		if (exchangeMode == EXCHANGE_REQUEST) 
+			serveDuringInterval(&exchange, nodeInterval);
+		else 
+			advanceClock(nodeInterval);
 
 		// Increase the iteration count (for randomizing number generation)
 		count++; 
 	}
 
+	// Tell the base station this node is done after its last report, with an empty report, then serve the neighbours until termination
+	if (finiteRun && !exchange.terminated) {
+		flushReports(&sender, 1);
+		MPI_Send(NULL, 0, MPI_BYTE, 0, REPORT_TAG, reportComm);
+		while (!exchange.terminated) 
+			processEvents(&exchange, 1);
+	}
+	if (recordPrefix != NULL || replayPrefix != NULL) 
+		closeRecord(&record);
+
+	// Clear all pending communications with neighbours
+	clearPendingCommunications(&exchange);
+
+	// Summarize the exchange statistics and resource usage of all nodes
+	reportExchangeStatistics(comm, exchange.messagesSent, &latencies, neighboursCount);
+	reportSenderStatistics(comm, &sender);
+	freeHistogram(&latencies);
+	reportResourceUsage(comm, "Node", 1);
+	sumCPUTime(commWorld);
+
 	// Output terminated message
 	printf("Node %d terminated\n", rank);
 
+	// Write the remaining trace events out
+	closeTrace(&trace);
+
 	// Free cartesian grid communicator
 	MPI_Comm_free(&cartComm);
 
@@ -176,29 +259,21 @@ void node(MPI_Comm commWorld, MPI_Comm comm) {
 }
 
 
-void sendMACAndIPAddress(FILE* fptr, MPI_Comm commWorld, int baseRank) {	
-	/**	
-	 * Sends the MAC address and IP address of the rank to the base station for record purpose	
-	 */	
-		/// CHANGE BUFFER SIZE!
-	// Get the MAC and IP addresses	
-	char MACAddress[50];	
-	char IPAddress[16];	
-	getMACAddress(MACAddress);	
-	getIPAddress(IPAddress);	
-	
-	// Pack and send the addresses to the base station	
-	int position = 0;	
-	int addressBufferSize = 100;	
-	char addressBuffer[addressBufferSize];	
-	MPI_Pack(MACAddress, 18, MPI_CHAR, addressBuffer, addressBufferSize, &position, commWorld);	
-	MPI_Pack(IPAddress, 16, MPI_CHAR, addressBuffer, addressBufferSize, &position, commWorld);	
-	MPI_Send(addressBuffer, addressBufferSize, MPI_PACKED, baseRank, ADDRESSES_TAG, commWorld);	
+void shareAddress(TraceBuffer* trace, MPI_Comm commWorld) {
+	/**
+	 * Shares the MAC and IP addresses of the rank's host with the base station for record purpose, and logs them
+	 */
 
-	// Log the MAC and IP addresses
-	fprintf(fptr, "MAC Address: %s\n", MACAddress);
-	fprintf(fptr, "IP Address: %s\n", IPAddress);
+	// Get the addresses, gathered by the base station with those of all ranks
+	NodeAddress nodeAddress;
+	gatherAddresses(commWorld, &nodeAddress);
 
+	// Log the MAC and IP addresses
+	unsigned char mac[6] = {0};
+	struct in_addr address;
+	sscanf(nodeAddress.macAddress, "%hhX:%hhX:%hhX:%hhX:%hhX:%hhX", &mac[0], &mac[1], &mac[2], &mac[3], &mac[4], &mac[5]);
+	traceEvent(trace, TRACE_MAC_ADDRESS, -1, ((long long) mac[0] << 40) | ((long long) mac[1] << 32) | ((long long) mac[2] << 24) | (mac[3] << 16) | (mac[4] << 8) | mac[5]);
+	traceEvent(trace, TRACE_IP_ADDRESS, -1, inet_pton(AF_INET, nodeAddress.ipAddress, &address) == 1? (long long) address.s_addr: -1);
 }
 
 
@@ -225,12 +300,110 @@ void initCartesianTopology(MPI_Comm comm, int rows, int cols, MPI_Comm* cartComm
 }
 
 
+void exchangeNodeInfo(MPI_Comm cartComm, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo) {
+	/**
+	 * Swaps the NodeInfo of the node with all its neighbours in one neighbourhood collective, 
+	 * keeping the neighbours' NodeInfo in the order of getValidNeighbours
+	 */
+
+	int i, count = 0, topology;
+
+	// The neighbourhood of a radio graph is in the order of getValidNeighbours already
+	MPI_Topo_test(cartComm, &topology);
+	if (topology == MPI_DIST_GRAPH) {
+		MPI_Neighbor_allgather(nodeInfo, 1, NodeInfoType, neighboursNodeInfo, 1, NodeInfoType, cartComm);
+		return;
+	}
+
+	// The cartesian neighbourhood is ordered by dimension, lower then upper: top, bottom, left then right. 
+	// The entry of a missing neighbour is left untouched, with its invalid rank
+	NodeInfo allNodeInfo[2 * N_DIMS];
+	for (i = 0; i < 2 * N_DIMS; i++) 
+		allNodeInfo[i].rank = -1;
+	MPI_Neighbor_allgather(nodeInfo, 1, NodeInfoType, allNodeInfo, 1, NodeInfoType, cartComm);
+
+	// Keep the valid neighbours as left, right, top then bottom
+	int order[2 * N_DIMS] = {2, 3, 0, 1};
+	for (i = 0; i < 2 * N_DIMS; i++) {
+		if (allNodeInfo[order[i]].rank >= 0) neighboursNodeInfo[count++] = allNodeInfo[order[i]];
+	}
+}
+
+
+void initDeploymentTopology(MPI_Comm comm, char* path, float range, MPI_Comm* graphComm, int* coord) {
+	/**
+	 * Loads the positions of the sensors and links each with its nearest sensors within radio range, then installs the links 
+	 * as a distributed graph topology the ranks may be reordered for. The first node builds the graph and shares it with 
+	 * the others. Each sensor is the node of its rank in comm, which indexes its position and its links, and stays its 
+	 * rank in the reports and the records. Its coordinates are the cell of the grid its position rounds to, clamped to the 
+	 * grid, which the base checks against the satellite. Its rank in graphComm, once reordered, only addresses it in the 
+	 * neighbour exchange
+	 */
+
+	int rank, size, linksCount;
+	double buildTime;
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+	SensorPosition* positions = (SensorPosition*) malloc(size * sizeof(SensorPosition));
+	int* offsets = (int*) malloc((size + 1) * sizeof(int));
+	int* links = (int*) malloc((long) size * MAX_NEIGHBOURS * sizeof(int));
+
+	if (rank == 0) {
+		if (loadPositions(path, positions, size) != 0) {
+			fflush(stdout);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		buildTime = MPI_Wtime();
+		linksCount = buildRadioGraph(positions, size, range, offsets, links);
+		buildTime = MPI_Wtime() - buildTime;
+		printf("Deployment: %d sensors with %d radio links (%.2f neighbours/sensor), built in %.3f ms\n", size, linksCount / 2, (double) linksCount / size, buildTime * 1e3);
+		fflush(stdout);
+	}
+
+	// Share the positions and the links of every sensor
+	MPI_Bcast(positions, 2 * size, MPI_DOUBLE, 0, comm);
+	MPI_Bcast(offsets, size + 1, MPI_INT, 0, comm);
+	MPI_Bcast(links, offsets[size], MPI_INT, 0, comm);
+
+	// The satellite only covers the grid, so a sensor deployed off it is checked against the nearest cell
+	coord[0] = (int) lround(positions[rank].x);
+	coord[1] = (int) lround(positions[rank].y);
+	coord[0] = coord[0] < 0? 0: coord[0] >= rows? rows - 1: coord[0];
+	coord[1] = coord[1] < 0? 0: coord[1] >= cols? cols - 1: coord[1];
+
+	// The links are symmetric, so the node's neighbours are both its sources and destinations, every link weighing the same
+	int i, weights[MAX_NEIGHBOURS];
+	int neighboursCount = offsets[rank + 1] - offsets[rank];
+	for (i = 0; i < MAX_NEIGHBOURS; i++) 
+		weights[i] = 1;
+	MPI_Dist_graph_create_adjacent(comm, neighboursCount, &links[offsets[rank]], weights, neighboursCount, &links[offsets[rank]], weights, 
+		MPI_INFO_NULL, 1, graphComm);
+
+	free(positions);
+	free(offsets);
+	free(links);
+}
+
+
 void getValidNeighbours(MPI_Comm cartComm, int** neighbours, int* neighboursCount) {
 	/**
 	 * Gets the valid neighbours (i.e., filtered neighours whose rank >= 0) rank and the total number of neighbours
 	 */
 	
-	int i, leftRank, rightRank, topRank, bottomRank;
+	int i, leftRank, rightRank, topRank, bottomRank, topology, sourcesCount, destinationsCount, weighted;
+
+	// the neighbours of a radio graph are its sources, which are also its destinations
+	MPI_Topo_test(cartComm, &topology);
+	if (topology == MPI_DIST_GRAPH) {
+		int sources[MAX_NEIGHBOURS], destinations[MAX_NEIGHBOURS], sourceWeights[MAX_NEIGHBOURS], destinationWeights[MAX_NEIGHBOURS];
+		MPI_Dist_graph_neighbors_count(cartComm, &sourcesCount, &destinationsCount, &weighted);
+		MPI_Dist_graph_neighbors(cartComm, sourcesCount, sources, sourceWeights, destinationsCount, destinations, destinationWeights);
+		*neighboursCount = sourcesCount;
+		*neighbours = (int*) malloc(sourcesCount * sizeof(int));
+		memcpy(*neighbours, sources, sourcesCount * sizeof(int));
+		return;
+	}
 
 	// getting all neighbours' rank
 	MPI_Cart_shift(cartComm, SHIFT_ROW, DISP, &topRank, &bottomRank);
@@ -273,134 +446,413 @@ int getMatchingCount(NodeInfo* neighboursNodeInfo, int temperature, int count) {
 }
 
 
-void sendTemperatureRequests(MPI_Comm cartComm, int* neighbours, int neighboursCount, NodeInfo* neighboursNodeInfo, MPI_Request* sendRequests, MPI_Request* recvRequests, int* waiting, FILE *fptr, int rank) {
+void initExchange(NodeExchange* exchange, MPI_Comm commWorld, MPI_Comm cartComm, int* neighbours, int neighboursCount, NodeInfo* neighboursNodeInfo, TraceBuffer* trace, int rank) {
+	/**
+	 * Initializes the temperature exchange of a node and pre-posts every receive it waits on
+	 */
+
+	int i, n = neighboursCount;
+
+	exchange->commWorld = commWorld;
+	exchange->cartComm = cartComm;
+	exchange->neighbours = neighbours;
+	exchange->neighboursCount = n;
+	exchange->neighboursNodeInfo = neighboursNodeInfo;
+	exchange->temperature = 0;
+	exchange->terminated = 0;
+	exchange->messagesSent = 0;
+	exchange->trace = trace;
+	exchange->rank = rank;
+
+	// Allocates the requests, the receives are laid out as [neighbours..., temperature request, termination, barrier]
+	exchange->sendRequests = (MPI_Request*) malloc(n * sizeof(MPI_Request));
+	exchange->pendingRequests = (MPI_Request*) malloc((n + 3) * sizeof(MPI_Request));
+	exchange->neighbourBuffers = (int (*)[2]) malloc(n * sizeof(int[2]));
+	exchange->neighbourEpochs = (int*) malloc(n * sizeof(int));
+	exchange->heldNeighbours = (int*) malloc(n * sizeof(int));
+	exchange->neighbourProgress = (int*) malloc(n * sizeof(int));
+	exchange->epoch = 0;
+	for (i = 0; i < n; i++) {
+		exchange->sendRequests[i] = exchange->pendingRequests[i] = MPI_REQUEST_NULL;
+		exchange->neighbourEpochs[i] = -1;
+		exchange->heldNeighbours[i] = 0;
+		exchange->neighbourProgress[i] = -1;
+	}
+	exchange->pendingRequests[n] = exchange->pendingRequests[n + 2] = MPI_REQUEST_NULL;
+	exchange->replyRequest = MPI_REQUEST_NULL;
+
+	// Set up the persistent exchange once, it is restarted every epoch
+	if (exchangeMode == EXCHANGE_PERSISTENT) {
+		for (i = 0; i < n; i++) {
+			MPI_Send_init(exchange->publishBuffer, 2, MPI_INT, neighbours[i], PUBLISH_TAG, cartComm, &exchange->sendRequests[i]);
+			MPI_Recv_init(exchange->neighbourBuffers[i], 2, MPI_INT, neighbours[i], PUBLISH_TAG, cartComm, &exchange->pendingRequests[i]);
+		}
+		MPI_Startall(n, exchange->pendingRequests);
+	} else if (exchangeMode == EXCHANGE_RMA) {
+		// Expose the readings in a window every neighbour may read at any time, locked once for the whole run. 
+		// It holds a slot per epoch of the last EXCHANGE_MAX_LAG + 1, then the latest epoch exposed, none at first
+		MPI_Comm_rank(cartComm, &exchange->windowRank);
+		MPI_Win_allocate(READING_SLOTS * sizeof(long long), sizeof(long long), MPI_INFO_NULL, cartComm, &exchange->readings, &exchange->readingWindow);
+		for (i = 0; i <= EXCHANGE_MAX_LAG; i++) 
+			exchange->readings[i] = packReading(-1, 0);
+		exchange->readings[LATEST_EPOCH_SLOT] = -1;
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, exchange->readingWindow);
+		MPI_Win_sync(exchange->readingWindow);
+		MPI_Barrier(cartComm);
+	} else {
+		MPI_Irecv(&exchange->requestBuffer, 1, MPI_INT, MPI_ANY_SOURCE, REQUEST_TAG, cartComm, &exchange->pendingRequests[n]);
+	}
+
+	// Listens for the termination signal from base station 
+	listenForTermination(&exchange->terminationBuffer, &exchange->pendingRequests[n + 1]);
+}
+
+
+void sendTemperatureRequests(NodeExchange* exchange) {
 	/**
 	 * Request temperature from neighbours 
 	 */
 	
-	int i, requested = 0;
+	static int requested = 0;
+	int i;
+
+	// The previous requests must have left before they are reissued
+	MPI_Waitall(exchange->neighboursCount, exchange->sendRequests, MPI_STATUSES_IGNORE);
 
 	// Go through all neighbours
-	for (i = 0; i < neighboursCount; i++) {
+	for (i = 0; i < exchange->neighboursCount; i++) {
 
 		// Send temperature request to neighbours
-		MPI_Isend(&requested, 1, MPI_INT, neighbours[i], REQUEST_TAG, cartComm, &sendRequests[i]);
-		MPI_Irecv(&neighboursNodeInfo[i].temperature, 1, MPI_INT, neighbours[i], TEMPERATURE_TAG, cartComm, &recvRequests[i]);
+		MPI_Isend(&requested, 1, MPI_INT, exchange->neighbours[i], REQUEST_TAG, exchange->cartComm, &exchange->sendRequests[i]);
+		MPI_Irecv(&exchange->neighboursNodeInfo[i].temperature, 1, MPI_INT, exchange->neighbours[i], TEMPERATURE_TAG, exchange->cartComm, &exchange->pendingRequests[i]);
 
 		// Log the request message
-		fprintf(fptr, "Rank %d requesting temperature from neighbour rank %d\n", rank, neighbours[i]);
-		fprintf(fptr, "Rank %d awaiting for temperature from neighbour rank %d\n", rank, neighbours[i]);
+		traceEvent(exchange->trace, TRACE_REQUEST_SENT, exchange->neighbours[i], 0);
 	}
+	exchange->messagesSent += exchange->neighboursCount;
+}
+
+
+void publishTemperature(NodeExchange* exchange, int epoch) {
+	/**
+	 * Restarts the persistent sends of this node's temperature for the given epoch to all neighbours
+	 */
+
+	int i;
+
+	// The previous epoch must have left the buffer before it is overwritten
+	MPI_Waitall(exchange->neighboursCount, exchange->sendRequests, MPI_STATUSES_IGNORE);
 
-	// Sets waiting to be true
-	*waiting = 1;
+	exchange->publishBuffer[0] = epoch;
+	exchange->publishBuffer[1] = exchange->temperature;
+	MPI_Startall(exchange->neighboursCount, exchange->sendRequests);
+	exchange->messagesSent += exchange->neighboursCount;
 
+	// Log the publish message
+	for (i = 0; i < exchange->neighboursCount; i++) 
+		traceEvent(exchange->trace, TRACE_PUBLISHED, exchange->neighbours[i], exchange->temperature);
 }
 
 
-void checkTemperatureRequest(MPI_Comm cartComm, MPI_Request *tempSentReq, int temperature, FILE *fptr, int rank) {
+long long packReading(int epoch, int temperature) {
 	/**
-	 * Checks for any incoming requests for temperature and send it accordingly
+	 * Packs the epoch and the temperature of a reading into one window element, so a neighbour reads both atomically
 	 */
-	
-	int granted, requestFlag = 0;
-	MPI_Status status;
 
-	// sending the temperature to the requested neighbour
-	MPI_Iprobe(MPI_ANY_SOURCE, REQUEST_TAG, cartComm, &requestFlag, &status);
-	if (requestFlag) {
-		MPI_Recv(&granted, 1, MPI_INT, status.MPI_SOURCE, REQUEST_TAG, cartComm, &status);
-		MPI_Isend(&temperature, 1, MPI_INT, status.MPI_SOURCE, TEMPERATURE_TAG, cartComm, tempSentReq);
+	return (long long) epoch * (1LL << 32) + (unsigned int) temperature;
+}
+
+
+void exposeReading(NodeExchange* exchange, int epoch) {
+	/**
+	 * Exposes this node's temperature of the given epoch in its window, in the epoch's slot, and the epoch as its latest. 
+	 * The slot held the epoch EXCHANGE_MAX_LAG + 1 before, so it first waits for every neighbour to have exposed 
+	 * epoch - EXCHANGE_MAX_LAG, past which none reads that slot any more
+	 */
 
-		// Log the sending of temperature 
-		fprintf(fptr, "Rank %d has received request from %d and sent the temperature %d to rank %d\n", rank, status.MPI_SOURCE, temperature, status.MPI_SOURCE);
+	int i;
+	long long reading = packReading(epoch, exchange->temperature), latest = epoch, progress;
+
+	// Look up a neighbour's progress again only once the last one seen is too far behind
+	for (i = 0; i < exchange->neighboursCount; i++) {
+		while (!exchange->terminated && exchange->neighbourProgress[i] < epoch - EXCHANGE_MAX_LAG) {
+			MPI_Fetch_and_op(NULL, &progress, MPI_LONG_LONG, exchange->neighbours[i], LATEST_EPOCH_SLOT, MPI_NO_OP, exchange->readingWindow);
+			MPI_Win_flush(exchange->neighbours[i], exchange->readingWindow);
+			exchange->neighbourProgress[i] = (int) progress;
+			exchange->messagesSent++;
+			if (exchange->neighbourProgress[i] < epoch - EXCHANGE_MAX_LAG) 
+				processEvents(exchange, 0);
+		}
 	}
+
+	MPI_Accumulate(&reading, 1, MPI_LONG_LONG, exchange->windowRank, epoch % (EXCHANGE_MAX_LAG + 1), 1, MPI_LONG_LONG, MPI_REPLACE, exchange->readingWindow);
+	MPI_Accumulate(&latest, 1, MPI_LONG_LONG, exchange->windowRank, LATEST_EPOCH_SLOT, 1, MPI_LONG_LONG, MPI_REPLACE, exchange->readingWindow);
+	MPI_Win_flush(exchange->windowRank, exchange->readingWindow);
 }
 
 
-void checkTermination(MPI_Comm commWorld, int* terminated, int baseRank, FILE* fptr, int rank) {
+void readNeighbourTemperatures(NodeExchange* exchange, int epoch) {
 	/**
-	 * Checks for any termination signal sent from the base station 
+	 * Reads the temperature of the given epoch of every neighbour not read yet from the epoch's slot of its window, 
+	 * without the neighbour taking part. A neighbour whose slot still holds an earlier epoch is read again later. 
+	 * Each read is an atomic fetch, as the neighbour may be replacing its reading at the same time
 	 */
-	
-	int terminationFlag = 0;
-	MPI_Status status;
 
-	// receiving the termination signal from base station 
-	MPI_Iprobe(baseRank, TERMINATION_TAG, commWorld, &terminationFlag, &status);
-	if (terminationFlag) { 
-		MPI_Recv(terminated, 1, MPI_INT, status.MPI_SOURCE, TERMINATION_TAG, commWorld, &status);
+	int i;
+	long long readings[exchange->neighboursCount > 0? exchange->neighboursCount: 1];
+
+	for (i = 0; i < exchange->neighboursCount; i++) {
+		if (exchange->neighbourEpochs[i] >= epoch) continue;
+		MPI_Fetch_and_op(NULL, &readings[i], MPI_LONG_LONG, exchange->neighbours[i], epoch % (EXCHANGE_MAX_LAG + 1), MPI_NO_OP, exchange->readingWindow);
+		exchange->messagesSent++;
 
-		// Log the termination
-		fprintf(fptr, "Rank %d has received the termination signal\n", rank);
+		// Log the read
+		traceEvent(exchange->trace, TRACE_READ, exchange->neighbours[i], 0);
 	}
+	MPI_Win_flush_all(exchange->readingWindow);
 
+	// Keep the readings of this epoch
+	for (i = 0; i < exchange->neighboursCount; i++) {
+		if (exchange->neighbourEpochs[i] >= epoch || (int) (readings[i] >> 32) != epoch) continue;
+		exchange->neighbourEpochs[i] = epoch;
+		exchange->neighboursNodeInfo[i].temperature = (int) (readings[i] & 0xffffffff);
+	}
+}
+
+
+void serveDuringInterval(NodeExchange* exchange, double seconds) {
+	/**
+	 * Lets the given seconds pass while serving the requests and termination signal as they arrive, so a hot neighbour 
+	 * gets its reply within NODE_POLL_INTERVAL rather than once this node's interval is over. MPI has no blocking wait 
+	 * with a timeout, so the pre-posted receives are tested between short sleeps until the interval is over
+	 */
+
+	double remaining, endTime = MPI_Wtime() + seconds;
+
+	if (isVirtualClock()) {
+		advanceClock(seconds);
+		return;
+	}
+	while (!exchange->terminated && (remaining = endTime - MPI_Wtime()) > 0) {
+		if (processEvents(exchange, 0) == 0) 
+			advanceClock(remaining < NODE_POLL_INTERVAL / 1e6? remaining: NODE_POLL_INTERVAL / 1e6);
+	}
+}
+
+
+void waitForNodes(NodeExchange* exchange, MPI_Comm comm) {
+	/**
+	 * Waits for every node to reach this iteration, serving the neighbours meanwhile, so the nodes run apart 
+	 * by one synchronization interval at most on the virtual clock. The barrier is waited on with the pre-posted 
+	 * receives, so the node blocks until either completes. The base station only terminates a run on the virtual 
+	 * clock once every node is done, so none is left waiting here
+	 */
+
+	MPI_Request* barrierRequest = &exchange->pendingRequests[exchange->neighboursCount + 2];
+
+	MPI_Ibarrier(comm, barrierRequest);
+	while (*barrierRequest != MPI_REQUEST_NULL) 
+		processEvents(exchange, 1);
+}
+
+
+void advanceEpoch(NodeExchange* exchange, int epoch) {
+	/**
+	 * Moves the exchange on to the given epoch, restarting the receives held at the previous one
+	 */
+
+	int i;
+
+	exchange->epoch = epoch;
+	for (i = 0; i < exchange->neighboursCount; i++) {
+		if (!exchange->heldNeighbours[i]) continue;
+		exchange->heldNeighbours[i] = 0;
+		MPI_Start(&exchange->pendingRequests[i]);
+	}
+}
+
+
+int processEvents(NodeExchange* exchange, int blocking) {
+	/**
+	 * Handles every completed pre-posted receive, blocking until at least one completes if requested, and returns the number handled
+	 */
+
+	int i, index, completedCount, n = exchange->neighboursCount;
+	int completedIndices[n + 3];
+	MPI_Status completedStatuses[n + 3];
+
+	if (blocking)
+		MPI_Waitsome(n + 3, exchange->pendingRequests, &completedCount, completedIndices, completedStatuses);
+	else
+		MPI_Testsome(n + 3, exchange->pendingRequests, &completedCount, completedIndices, completedStatuses);
+	if (completedCount == MPI_UNDEFINED) return 0;
+
+	for (i = 0; i < completedCount; i++) {
+		index = completedIndices[i];
+
+		if (index < n) {
+			// A neighbour's temperature arrived, keep it and restart the persistent receive unless it is of the current epoch,
+			// so the temperature compared is always the neighbour's reading of the same epoch
+			if (exchangeMode == EXCHANGE_PERSISTENT) {
+				exchange->neighbourEpochs[index] = exchange->neighbourBuffers[index][0];
+				exchange->neighboursNodeInfo[index].temperature = exchange->neighbourBuffers[index][1];
+				if (exchange->neighbourEpochs[index] < exchange->epoch) 
+					MPI_Start(&exchange->pendingRequests[index]);
+				else 
+					exchange->heldNeighbours[index] = 1;
+			}
+		} else if (index == n) {
+			// A neighbour is requesting for my temperature
+			respondToTemperatureRequest(exchange, completedStatuses[i].MPI_SOURCE);
+		} else if (index == n + 1) {
+			// Base station has sent the termination signal
+			exchange->terminated = 1;
+			traceEvent(exchange->trace, TRACE_TERMINATION, -1, 0);
+		}
+	}
+	return completedCount;
+}
+
+
+void respondToTemperatureRequest(NodeExchange* exchange, int source) {
+	/**
+	 * Sends the current temperature to the requesting neighbour and re-posts the receive for the next request
+	 */
+
+	// the reply buffer must not be overwritten until the previous reply has left
+	MPI_Wait(&exchange->replyRequest, MPI_STATUS_IGNORE);
+	exchange->replyTemperature = exchange->temperature;
+	MPI_Isend(&exchange->replyTemperature, 1, MPI_INT, source, TEMPERATURE_TAG, exchange->cartComm, &exchange->replyRequest);
+	exchange->messagesSent++;
+
+	// Log the sending of temperature 
+	traceEvent(exchange->trace, TRACE_REQUEST_SERVED, source, exchange->temperature);
+
+	MPI_Irecv(&exchange->requestBuffer, 1, MPI_INT, MPI_ANY_SOURCE, REQUEST_TAG, exchange->cartComm, &exchange->pendingRequests[exchange->neighboursCount]);
+}
+
+
+int hasReceivedAllTemperatures(NodeExchange* exchange, int epoch) {
+	/**
+	 * Returns true if every neighbour's temperature for the given epoch has been received
+	 */
+
+	int i;
+	for (i = 0; i < exchange->neighboursCount; i++) {
+		if (exchangeMode != EXCHANGE_REQUEST && exchange->neighbourEpochs[i] < epoch) return 0;
+		if (exchangeMode == EXCHANGE_REQUEST && exchange->pendingRequests[i] != MPI_REQUEST_NULL) return 0;
+	}
+	return 1;
+}
+
+
+void reportExchangeStatistics(MPI_Comm comm, long messagesSent, Histogram* latencies, int neighboursCount) {
+	/**
+	 * Sums the neighbour exchange statistics of all nodes and prints the messages per detection and the percentiles 
+	 * of the request to all replies latency, overall and per neighbour count
+	 */
+
+	int rank, i;
+	long totalMessages;
+	Histogram totalLatencies, emptyLatencies;
+	initHistogram(&totalLatencies, latencies->precision);
+	initHistogram(&emptyLatencies, latencies->precision);
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Reduce(&messagesSent, &totalMessages, 1, MPI_LONG, MPI_SUM, 0, comm);
+	reduceHistogram(latencies, &totalLatencies, 0, comm);
+
+	if (rank == 0 && totalLatencies.totalCount > 0) {
+		printf("Exchange (%s): %ld messages, %ld detections, %.2f messages/detection\n", getExchangeModeName(exchangeMode), 
+			totalMessages, totalLatencies.totalCount, (double) totalMessages / totalLatencies.totalCount);
+		printLatencyPercentiles("all nodes", &totalLatencies);
+	}
+
+	// Each node only contributes its latencies to the histogram of its own neighbour count
+	for (i = 2; i <= MAX_NEIGHBOURS; i++) {
+		reduceHistogram(i == neighboursCount? latencies: &emptyLatencies, &totalLatencies, 0, comm);
+		if (rank == 0 && totalLatencies.totalCount > 0) {
+			char label[32];
+			sprintf(label, "%d neighbours", i);
+			printLatencyPercentiles(label, &totalLatencies);
+		}
+	}
+	fflush(stdout);
+
+	freeHistogram(&totalLatencies);
+	freeHistogram(&emptyLatencies);
+}
+
+
+void printLatencyPercentiles(char* label, Histogram* latencies) {
+	/**
+	 * Prints the percentiles of a histogram of exchange latencies in milliseconds
+	 */
+
+	printf("Exchange latency (%s): %ld samples, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n", label, latencies->totalCount, 
+		getValueAtPercentile(latencies, 50) / 1e6, getValueAtPercentile(latencies, 90) / 1e6, getValueAtPercentile(latencies, 99) / 1e6, 
+		getValueAtPercentile(latencies, 99.9) / 1e6, latencies->maxValue / 1e6);
 }
 
 
-void clearPendingCommunications(int neighboursCount, MPI_Request* sendRequests, MPI_Request* recvRequests, MPI_Request* tempSentReq) {
+void clearPendingCommunications(NodeExchange* exchange) {
 	/**
 	 * Cleans up the process upon returning by clearing all pending communications
 	 */
 	
-	int i, sendCompleted, recvCompleted, tempSentCompleted;
+	int i, sendCompleted, recvCompleted, replyCompleted, n = exchange->neighboursCount;
 
-	for (i = 0; i < neighboursCount; i++) {
+	for (i = 0; i < n + 1; i++) {
 		sendCompleted = recvCompleted = 0;
 	
-		// cancel the temperature request from neighbour if it has not completed
-		MPI_Test(&sendRequests[i], &sendCompleted, MPI_STATUS_IGNORE);
-		if (!sendCompleted) {
-			MPI_Cancel(&sendRequests[i]);
-			MPI_Request_free(&sendRequests[i]);
+		// cancel the temperature request or publish to neighbour if it has not completed
+		if (i < n) {
+			MPI_Test(&exchange->sendRequests[i], &sendCompleted, MPI_STATUS_IGNORE);
+			if (!sendCompleted) 
+				MPI_Cancel(&exchange->sendRequests[i]);
+			if (exchange->sendRequests[i] != MPI_REQUEST_NULL) 
+				MPI_Request_free(&exchange->sendRequests[i]);
 		}
 
-		// cancel the temperature receive from neighbour if it has not completed
-		MPI_Test(&recvRequests[i], &recvCompleted, MPI_STATUS_IGNORE);
+		// cancel the receive from neighbour or of temperature requests if it has not completed
+		MPI_Test(&exchange->pendingRequests[i], &recvCompleted, MPI_STATUS_IGNORE);
 		if (!recvCompleted) {
-			MPI_Cancel(&recvRequests[i]);
-			MPI_Request_free(&recvRequests[i]);
+			MPI_Cancel(&exchange->pendingRequests[i]);
+			MPI_Wait(&exchange->pendingRequests[i], MPI_STATUS_IGNORE);
 		}
+		if (exchange->pendingRequests[i] != MPI_REQUEST_NULL) 
+			MPI_Request_free(&exchange->pendingRequests[i]);
 	}
 
 	// cancel the sending of temperature to neighbour if it has not completed
-	MPI_Test(tempSentReq, &tempSentCompleted, MPI_STATUS_IGNORE);
-	if (!tempSentCompleted) {
-		MPI_Cancel(tempSentReq);
-		MPI_Request_free(tempSentReq);
+	MPI_Test(&exchange->replyRequest, &replyCompleted, MPI_STATUS_IGNORE);
+	if (!replyCompleted) {
+		MPI_Cancel(&exchange->replyRequest);
+		MPI_Request_free(&exchange->replyRequest);
 	}
-}
 
+	// Release the window once every node is done reading it
+	if (exchangeMode == EXCHANGE_RMA) {
+		MPI_Win_unlock_all(exchange->readingWindow);
+		MPI_Win_free(&exchange->readingWindow);
+	}
 
-void sendReport(MPI_Comm commWorld, int baseRank, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount) {
-	/**
-	 * Sends the report to base station
-	 */
-	
-	// Obtain the current reporting time
-	time_t now;	
-	time(&now);
-
-	// Obtain the alert information
-	Alert alert;
-	alert.timestamp = now;
-	alert.matchCount = matchCount;
-	alert.commStartTime = MPI_Wtime();
-
-	// Initialize buffer for sending report
-	int reportBufferSize = 200; 
-	char reportBuffer[reportBufferSize];
-	int i, position = 0;
-
-	// Packing alert, number of neighbours and all node's information
-	MPI_Pack(&alert, 1, AlertType, reportBuffer, reportBufferSize, &position, commWorld);
-	MPI_Pack(nodeInfo, 1, NodeInfoType, reportBuffer, reportBufferSize, &position, commWorld);
-	MPI_Pack(&neighboursCount, 1, MPI_INT, reportBuffer, reportBufferSize, &position, commWorld);
-	for (i = 0; i < neighboursCount; i++) 
-		MPI_Pack(&neighboursNodeInfo[i], 1, NodeInfoType, reportBuffer, reportBufferSize, &position, commWorld);
-	MPI_Send(reportBuffer, position, MPI_PACKED, baseRank, REPORT_TAG, commWorld);
-	
+	// Free dynamic arrays
+	free(exchange->sendRequests);
+	free(exchange->pendingRequests);
+	free(exchange->neighbourBuffers);
+	free(exchange->neighbourEpochs);
+	free(exchange->heldNeighbours);
+	free(exchange->neighbourProgress);
 }
 
 
+char* getExchangeModeName(int mode) {
+	/**
+	 * Returns the name of a neighbour temperature exchange mode, as given to --exchange
+	 */
 
+	if (mode == EXCHANGE_PERSISTENT) return "persistent";
+	if (mode == EXCHANGE_RMA) return "rma";
+	return "request";
+}
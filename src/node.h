@@ -1,25 +1,91 @@
 #ifndef NODE_H
 #define NODE_H
 
+#include "./trace.h"
+#include "./histogram.h"
+
+// Define the layout of a node's reading window in rma exchange: a slot per epoch of the last EXCHANGE_MAX_LAG + 1, then the latest epoch
+#define LATEST_EPOCH_SLOT (EXCHANGE_MAX_LAG + 1)
+#define READING_SLOTS (EXCHANGE_MAX_LAG + 2)
+
+// Define NodeExchange structure, to store the state of a node's temperature exchange with its neighbours.
+// The receives a node waits on are pre-posted in pendingRequests as [neighbours..., temperature request, termination], 
+// followed by the barrier of the nodes while the node waits for them on the virtual clock.
+// A neighbour's receive is held once it delivers the current epoch, so later epochs wait until the node reaches them
+typedef struct {
+	MPI_Comm commWorld;
+	MPI_Comm cartComm;
+	int* neighbours;
+	int neighboursCount;
+	NodeInfo* neighboursNodeInfo;
+	MPI_Request* sendRequests;
+	MPI_Request* pendingRequests;
+	MPI_Request replyRequest;
+	int (*neighbourBuffers)[2];
+	int* neighbourEpochs;
+	int* heldNeighbours;
+	int* neighbourProgress;
+	int epoch;
+	int publishBuffer[2];
+	int requestBuffer;
+	int replyTemperature;
+	int terminationBuffer;
+	int temperature;
+	int terminated;
+	MPI_Win readingWindow;
+	long long* readings;
+	int windowRank;
+	long messagesSent;
+	TraceBuffer* trace;
+	int rank;
+} NodeExchange;
+
+
 // Function definitions for node.c
 void node(MPI_Comm commWorld, MPI_Comm comm);
 
-void sendMACAndIPAddress(FILE* fptr, MPI_Comm commWorld, int baseRank);
+void shareAddress(TraceBuffer* trace, MPI_Comm commWorld);
 
 void initCartesianTopology(MPI_Comm comm, int rows, int cols, MPI_Comm* cartComm);
 
+void exchangeNodeInfo(MPI_Comm cartComm, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo);
+
+void initDeploymentTopology(MPI_Comm comm, char* path, float range, MPI_Comm* graphComm, int* coord);
+
 void getValidNeighbours(MPI_Comm cartComm, int** neighbours, int* neighboursCount);
 
 int getMatchingCount(NodeInfo* neighboursNodeInfo, int temperature, int count);
 
-void sendTemperatureRequests(MPI_Comm cartComm, int* neighbours, int neighboursCount, NodeInfo* neighboursNodeInfo, MPI_Request* sendRequests, MPI_Request* recvRequests, int* waiting, FILE *fptr, int rank);
+void initExchange(NodeExchange* exchange, MPI_Comm commWorld, MPI_Comm cartComm, int* neighbours, int neighboursCount, NodeInfo* neighboursNodeInfo, TraceBuffer* trace, int rank);
+
+void sendTemperatureRequests(NodeExchange* exchange);
+
+void advanceEpoch(NodeExchange* exchange, int epoch);
+
+void serveDuringInterval(NodeExchange* exchange, double seconds);
+
+void waitForNodes(NodeExchange* exchange, MPI_Comm comm);
+
+void publishTemperature(NodeExchange* exchange, int epoch);
+
+long long packReading(int epoch, int temperature);
+
+void exposeReading(NodeExchange* exchange, int epoch);
+
+void readNeighbourTemperatures(NodeExchange* exchange, int epoch);
+
+int processEvents(NodeExchange* exchange, int blocking);
+
+void respondToTemperatureRequest(NodeExchange* exchange, int source);
+
+int hasReceivedAllTemperatures(NodeExchange* exchange, int epoch);
 
-void checkTemperatureRequest(MPI_Comm cartComm, MPI_Request *tempSentReq, int temperature, FILE *fptr, int rank);
+void reportExchangeStatistics(MPI_Comm comm, long messagesSent, Histogram* latencies, int neighboursCount);
+void printLatencyPercentiles(char* label, Histogram* latencies);
 
-void checkTermination(MPI_Comm commWorld, int* terminated, int baseRank, FILE* fptr, int rank);
+void clearPendingCommunications(NodeExchange* exchange);
 
-void clearPendingCommunications(int neighboursCount, MPI_Request* sendRequests, MPI_Request* recvRequests, MPI_Request* tempSentReq);
+char* getExchangeModeName(int mode);
 
-void sendReport(MPI_Comm commWorld, int baseRank, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "./init.h"
+#include "./record.h"
+
+
+void getRecordFilename(char* filename, char* prefix, int rank) {
+	/**
+	 * Writes the name of the record file of a rank, or of the satellite frames, under the prefix
+	 */
+
+	if (rank == RECORD_FRAMES) sprintf(filename, "%s_frames.bin", prefix);
+	else sprintf(filename, "%s_node_%d.bin", prefix, rank);
+}
+
+
+int openRecord(RecordFile* record, char* prefix, int rank, int cellsCount) {
+	/**
+	 * Creates the record file of a rank, or of the satellite frames, to write its samples in, returning -1 if it cannot be created
+	 */
+
+	char filename[strlen(prefix) + 32];
+
+	getRecordFilename(filename, prefix, rank);
+	record->fptr = fopen(filename, "wb");
+	if (record->fptr == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	memcpy(record->header.magic, RECORD_MAGIC, sizeof(record->header.magic));
+	record->header.version = RECORD_VERSION;
+	record->header.rank = rank;
+	record->header.rows = rows;
+	record->header.cols = cols;
+	record->header.cellsCount = cellsCount;
+	record->header.reserved = 0;
+	record->header.seed = randomSeed;
+	fwrite(&record->header, sizeof(RecordHeader), 1, record->fptr);
+
+	record->buffer = (unsigned char*) malloc(cellsCount);
+	record->samplesCount = 0;
+	return 0;
+}
+
+
+int openReplay(RecordFile* record, char* prefix, int rank, int cellsCount) {
+	/**
+	 * Opens the record file of a rank, or of the satellite frames, to read its samples back, counting them. 
+	 * Returns -1 if the file is missing or was recorded for another grid or layout
+	 */
+
+	char filename[strlen(prefix) + 32];
+	struct stat status;
+
+	getRecordFilename(filename, prefix, rank);
+	record->fptr = fopen(filename, "rb");
+	if (record->fptr == NULL) {
+		perror(filename);
+		return -1;
+	}
+
+	if (fread(&record->header, sizeof(RecordHeader), 1, record->fptr) != 1 || memcmp(record->header.magic, RECORD_MAGIC, sizeof(record->header.magic)) != 0 
+		|| record->header.version != RECORD_VERSION || record->header.rows != rows || record->header.cols != cols || record->header.cellsCount != cellsCount) {
+		fprintf(stderr, "ERROR: %s is not a version %d record of %d readings per sample on a (%d x %d) grid\n", filename, RECORD_VERSION, cellsCount, rows, cols);
+		fclose(record->fptr);
+		return -1;
+	}
+
+	fstat(fileno(record->fptr), &status);
+	record->buffer = (unsigned char*) malloc(cellsCount);
+	record->samplesCount = (status.st_size - sizeof(RecordHeader)) / (sizeof(long) + cellsCount);
+	return 0;
+}
+
+
+void writeRecord(RecordFile* record, long timestamp, int* values, int rowLength, int stride) {
+	/**
+	 * Appends a sample, its readings being rows of rowLength values stride apart
+	 */
+
+	int i, j, k = 0;
+
+	for (i = 0; k < record->header.cellsCount; i += stride) 
+		for (j = 0; j < rowLength; j++) 
+			record->buffer[k++] = (unsigned char) values[i + j];
+	fwrite(&timestamp, sizeof(long), 1, record->fptr);
+	fwrite(record->buffer, 1, record->header.cellsCount, record->fptr);
+	record->samplesCount++;
+}
+
+
+int readRecord(RecordFile* record, long* timestamp, int* values, int rowLength, int stride) {
+	/**
+	 * Reads the next sample into rows of rowLength values stride apart, returning false once every sample has been read
+	 */
+
+	int i, j, k = 0;
+
+	if (fread(timestamp, sizeof(long), 1, record->fptr) != 1 || fread(record->buffer, 1, record->header.cellsCount, record->fptr) != (size_t) record->header.cellsCount) 
+		return 0;
+	for (i = 0; k < record->header.cellsCount; i += stride) 
+		for (j = 0; j < rowLength; j++) 
+			values[i + j] = record->buffer[k++];
+	return 1;
+}
+
+
+void closeRecord(RecordFile* record) {
+	/**
+	 * Closes a record file, writing out the samples still buffered
+	 */
+
+	fclose(record->fptr);
+	free(record->buffer);
+}
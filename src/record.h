@@ -0,0 +1,41 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <stdio.h>
+
+// Define record constants
+#define RECORD_MAGIC "WSNREC\0\0"
+#define RECORD_VERSION 1
+#define RECORD_FRAMES -1 // rank in the header of the satellite frames' record
+
+
+// Define RecordHeader structure, written once at the start of a record file
+typedef struct {
+	char magic[8];
+	int version;
+	int rank; // node rank of the readings, or RECORD_FRAMES
+	int rows;
+	int cols;
+	int cellsCount; // readings of each sample: 1 for a node, the sensors of a tile, or the cells of a frame
+	int reserved;
+	unsigned long long seed;
+} RecordHeader;
+
+// Define RecordFile structure, to store an open record of samples, each one a timestamp followed by a byte per reading
+typedef struct {
+	FILE* fptr;
+	RecordHeader header;
+	unsigned char* buffer;
+	long samplesCount;
+} RecordFile;
+
+
+// Function definitions for record.c
+void getRecordFilename(char* filename, char* prefix, int rank);
+int openRecord(RecordFile* record, char* prefix, int rank, int cellsCount);
+int openReplay(RecordFile* record, char* prefix, int rank, int cellsCount);
+void writeRecord(RecordFile* record, long timestamp, int* values, int rowLength, int stride);
+int readRecord(RecordFile* record, long* timestamp, int* values, int rowLength, int stride);
+void closeRecord(RecordFile* record);
+
+#endif
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <time.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "./init.h"
+#include "./report.h"
+
+
+void initAlertType(MPI_Datatype* AlertType) {
+	/**
+	 * Initializes MPI datatype for Alert struct
+	 */	
+	
+	int alertBlockLen[3] = {1, 1, 1};
+	MPI_Datatype alertTypes[3] = {MPI_LONG, MPI_INT, MPI_DOUBLE};
+	MPI_Aint alertDisp[3];
+
+	alertDisp[0] = offsetof(Alert, timestamp);
+	alertDisp[1] = offsetof(Alert, matchCount);
+	alertDisp[2] = offsetof(Alert, commStartTime);
+	
+	MPI_Type_create_struct(3, alertBlockLen, alertDisp, alertTypes, AlertType);
+	MPI_Type_commit(AlertType);
+}
+
+
+void initNodeInfoType(MPI_Datatype* NodeInfoType) {
+	/**
+	 * Initializes MPI datatype for NodeInfo struct
+	 */
+	
+	int nodeInfoBlockLen[3] = {1, 2, 1};
+	MPI_Datatype nodeInfoTypes[5] = {MPI_INT, MPI_INT, MPI_INT};
+	MPI_Aint nodeInfoDisp[3];
+
+	nodeInfoDisp[0] = offsetof(NodeInfo, rank);
+	nodeInfoDisp[1] = offsetof(NodeInfo, coord);
+	nodeInfoDisp[2] = offsetof(NodeInfo, temperature);
+
+	MPI_Type_create_struct(3, nodeInfoBlockLen, nodeInfoDisp, nodeInfoTypes, NodeInfoType);
+	MPI_Type_commit(NodeInfoType);
+}
+
+
+void initReportType(MPI_Datatype* ReportType) {
+	/**
+	 * Initializes MPI datatype for Report struct, resized to the struct so arrays of reports can be received
+	 */
+
+	int reportBlockLen[4] = {1, 1, 1, MAX_NEIGHBOURS};
+	MPI_Datatype reportTypes[4] = {AlertType, NodeInfoType, MPI_INT, NodeInfoType};
+	MPI_Aint reportDisp[4];
+	MPI_Datatype structType;
+
+	reportDisp[0] = offsetof(Report, alert);
+	reportDisp[1] = offsetof(Report, reportingNode);
+	reportDisp[2] = offsetof(Report, neighboursCount);
+	reportDisp[3] = offsetof(Report, neighboursNodeInfo);
+
+	MPI_Type_create_struct(4, reportBlockLen, reportDisp, reportTypes, &structType);
+	MPI_Type_create_resized(structType, 0, sizeof(Report), ReportType);
+	MPI_Type_commit(ReportType);
+	MPI_Type_free(&structType);
+}
+
+
+int sendReport(MPI_Comm comm, int destination, long timestamp, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount) {
+	/**
+	 * Sends the report of the readings taken at the timestamp to the destination, the base station or the aggregator 
+	 * of the node's region. Returns the size of the report in bytes
+	 */
+
+	// Obtain the alert information
+	Alert alert;
+	alert.timestamp = timestamp;
+	alert.matchCount = matchCount;
+	alert.commStartTime = MPI_Wtime();
+
+	// Initialize buffer for sending report
+	int reportBufferSize = 200; 
+	char reportBuffer[reportBufferSize];
+	int i, position = 0;
+
+	// Packing alert, number of neighbours and all node's information
+	MPI_Pack(&alert, 1, AlertType, reportBuffer, reportBufferSize, &position, comm);
+	MPI_Pack(nodeInfo, 1, NodeInfoType, reportBuffer, reportBufferSize, &position, comm);
+	MPI_Pack(&neighboursCount, 1, MPI_INT, reportBuffer, reportBufferSize, &position, comm);
+	for (i = 0; i < neighboursCount; i++) 
+		MPI_Pack(&neighboursNodeInfo[i], 1, NodeInfoType, reportBuffer, reportBufferSize, &position, comm);
+	MPI_Send(reportBuffer, position, MPI_PACKED, destination, REPORT_TAG, comm);
+	return position;
+}
+
+
+int sendFixedReport(MPI_Comm comm, int destination, long timestamp, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount) {
+	/**
+	 * Sends the report of the readings taken at the timestamp to the destination as one fixed-size Report, without packing. 
+	 * Returns the size of the report in bytes
+	 */
+
+	// Clear the report first, so the neighbour slots past neighboursCount are not sent with whatever was on the stack
+	Report report;
+	memset(&report, 0, sizeof(Report));
+	report.alert.timestamp = timestamp;
+	report.alert.matchCount = matchCount;
+	report.alert.commStartTime = MPI_Wtime();
+	report.reportingNode = *nodeInfo;
+	report.neighboursCount = neighboursCount;
+	memcpy(report.neighboursNodeInfo, neighboursNodeInfo, neighboursCount * sizeof(NodeInfo));
+
+	MPI_Send(&report, 1, ReportType, destination, REPORT_TAG, comm);
+	return sizeof(Report);
+}
+
+
+int unpackReport(MPI_Comm comm, char* reportBuffer, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo) {
+	/**
+	 * Unpacks a packed report into the report fields, returning the number of neighbours
+	 */
+
+	int position = 0, i, neighboursCount;
+
+	MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, alert, 1, AlertType, comm);
+	MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, reportingNode, 1, NodeInfoType, comm);
+	MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &neighboursCount, 1, MPI_INT, comm);
+
+	// Unpack each neighbour
+	for (i = 0; i < neighboursCount; i++) 
+		MPI_Unpack(reportBuffer, REPORT_BUFFER_SIZE, &position, &neighboursNodeInfo[i], 1, NodeInfoType, comm);
+	return neighboursCount;
+}
+
+
+int decodeFixedReport(char* reportBuffer, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo) {
+	/**
+	 * Copies a fixed-size report, received as it is laid out in memory, into the report fields, returning the number of neighbours. 
+	 * The report is copied out whole, as a report inside a batch may not be aligned
+	 */
+
+	Report report;
+	memcpy(&report, reportBuffer, sizeof(Report));
+
+	*alert = report.alert;
+	*reportingNode = report.reportingNode;
+	memcpy(neighboursNodeInfo, report.neighboursNodeInfo, report.neighboursCount * sizeof(NodeInfo));
+	return report.neighboursCount;
+}
+
+
+void initReportSender(ReportSender* sender, MPI_Comm comm, int destination) {
+	/**
+	 * Initializes a sender of reports to the destination, the base station or the aggregator of the node's region
+	 */
+
+	sender->comm = comm;
+	sender->destination = destination;
+	sender->timestamp = (long) time(NULL);
+	sender->heldTimestamp = sender->timestamp;
+	sender->alertsCount = 0;
+	sender->alertsSent = 0;
+	sender->messagesSent = 0;
+	sender->bytesSent = 0;
+}
+
+
+void submitReport(ReportSender* sender, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount) {
+	/**
+	 * Sends the report of an alert, or adds it to the compact message and sends that once it holds enough alerts
+	 */
+
+	int i, direction;
+
+	if (reportFormat != REPORT_COMPACT) {
+		sender->alertsSent++;
+		if (reportFormat == REPORT_FIXED) 
+			sender->bytesSent += sendFixedReport(sender->comm, sender->destination, sender->timestamp, matchCount, nodeInfo, neighboursNodeInfo, neighboursCount);
+		else 
+			sender->bytesSent += sendReport(sender->comm, sender->destination, sender->timestamp, matchCount, nodeInfo, neighboursNodeInfo, neighboursCount);
+		sender->messagesSent++;
+		return;
+	}
+
+	// A finite run sends the alerts of each reading time apart, as its times are not those of the wall clock
+	if (finiteRun && sender->alertsCount > 0 && sender->heldTimestamp != sender->timestamp) 
+		flushReports(sender, 1);
+	sender->heldTimestamp = sender->timestamp;
+
+	CompactAlert* alert = (CompactAlert*) (sender->buffer + sizeof(CompactReportHeader)) + sender->alertsCount;
+	sender->alertTimes[sender->alertsCount] = MPI_Wtime();
+	alert->rank = nodeInfo->rank;
+	alert->temperature = (unsigned char) nodeInfo->temperature;
+	alert->matchCount = (unsigned char) matchCount;
+	alert->neighboursMask = 0;
+	alert->reserved = 0;
+
+	// Place each neighbour by its direction from the node
+	for (i = 0; i < neighboursCount; i++) {
+		if (neighboursNodeInfo[i].coord[0] == nodeInfo->coord[0]) 
+			direction = (neighboursNodeInfo[i].coord[1] < nodeInfo->coord[1])? 0: 1;
+		else 
+			direction = (neighboursNodeInfo[i].coord[0] < nodeInfo->coord[0])? 2: 3;
+		alert->neighboursMask |= 1 << direction;
+		alert->neighbourTemperatures[direction] = (unsigned char) neighboursNodeInfo[i].temperature;
+	}
+
+	if (++sender->alertsCount >= coalesceCount) 
+		flushReports(sender, 1);
+}
+
+
+void flushReports(ReportSender* sender, int force) {
+	/**
+	 * Sends the alerts held as one compact message, if forced or once the oldest has been held for the coalescing window. 
+	 * A finite run holds them for the window of its own clock instead, so the messages do not depend on its speed
+	 */
+
+	int i;
+	double now;
+
+	if (sender->alertsCount == 0) return;
+	now = MPI_Wtime();
+	if (!force && finiteRun && sender->timestamp - sender->heldTimestamp < coalesceWindow) return;
+	if (!force && !finiteRun && now - sender->alertTimes[0] < coalesceWindow) return;
+
+	// Stamp the message, and how long before it each alert was raised
+	CompactReportHeader header;
+	header.version = COMPACT_REPORT_VERSION;
+	header.reserved = 0;
+	header.alertsCount = (unsigned short) sender->alertsCount;
+	header.reserved2 = 0;
+	header.timestamp = finiteRun? sender->heldTimestamp: sender->timestamp;
+	header.commStartTime = now;
+	memcpy(sender->buffer, &header, sizeof(header));
+
+	CompactAlert* alerts = (CompactAlert*) (sender->buffer + sizeof(CompactReportHeader));
+	for (i = 0; i < sender->alertsCount; i++) 
+		alerts[i].age = (unsigned int) ((now - sender->alertTimes[i]) * 1e6);
+
+	int size = sizeof(CompactReportHeader) + sender->alertsCount * sizeof(CompactAlert);
+	MPI_Send(sender->buffer, size, MPI_PACKED, sender->destination, REPORT_TAG, sender->comm);
+	sender->alertsSent += sender->alertsCount;
+	sender->messagesSent++;
+	sender->bytesSent += size;
+	sender->alertsCount = 0;
+}
+
+
+void reportSenderStatistics(MPI_Comm comm, ReportSender* sender) {
+	/**
+	 * Sums the reports sent by all nodes and prints the messages and bytes per alert
+	 */
+
+	int rank;
+	long counts[3] = {sender->alertsSent, sender->messagesSent, sender->bytesSent};
+	long totalCounts[3];
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Reduce(counts, totalCounts, 3, MPI_LONG, MPI_SUM, 0, comm);
+	if (rank == 0 && totalCounts[0] > 0) {
+		printf("Reports (%s): %ld alerts in %ld messages, %.3f messages/alert, %.1f bytes/alert\n", reportFormat == REPORT_COMPACT? "compact": reportFormat == REPORT_FIXED? "fixed": "packed", 
+			totalCounts[0], totalCounts[1], (double) totalCounts[1] / totalCounts[0], (double) totalCounts[2] / totalCounts[0]);
+		fflush(stdout);
+	}
+}
+
+
+int decodeCompactAlert(char* message, int index, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo) {
+	/**
+	 * Decodes an alert of a compact message into the report fields, returning the number of neighbours, 
+	 * or -1 if the message has another version
+	 */
+
+	int direction, neighboursCount = 0;
+	int shifts[MAX_NEIGHBOURS][2] = {{0, -1}, {0, 1}, {-1, 0}, {1, 0}};
+	CompactReportHeader* header = (CompactReportHeader*) message;
+	CompactAlert* compactAlert = (CompactAlert*) (message + sizeof(CompactReportHeader)) + index;
+
+	if (header->version != COMPACT_REPORT_VERSION) return -1;
+
+	// The alert was raised its age before the message was sent
+	alert->timestamp = header->timestamp - (long) (compactAlert->age / 1000000);
+	alert->matchCount = compactAlert->matchCount;
+	alert->commStartTime = header->commStartTime - compactAlert->age / 1e6;
+
+	reportingNode->rank = compactAlert->rank;
+	reportingNode->coord[0] = compactAlert->rank / cols;
+	reportingNode->coord[1] = compactAlert->rank % cols;
+	reportingNode->temperature = compactAlert->temperature;
+
+	for (direction = 0; direction < MAX_NEIGHBOURS; direction++) {
+		if (!(compactAlert->neighboursMask & (1 << direction))) continue;
+		NodeInfo* neighbour = &neighboursNodeInfo[neighboursCount++];
+		neighbour->coord[0] = reportingNode->coord[0] + shifts[direction][0];
+		neighbour->coord[1] = reportingNode->coord[1] + shifts[direction][1];
+		neighbour->rank = neighbour->coord[0] * cols + neighbour->coord[1];
+		neighbour->temperature = compactAlert->neighbourTemperatures[direction];
+	}
+	return neighboursCount;
+}
@@ -0,0 +1,66 @@
+#ifndef REPORT_H
+#define REPORT_H
+
+// Define report constants
+#define REPORT_PACKED 0 // one MPI_Pack-ed message per alert
+#define REPORT_COMPACT 1 // alerts coalesced into compact fixed-layout messages
+#define REPORT_FIXED 2 // one Report per alert, sent and received as ReportType without packing
+#define COMPACT_REPORT_VERSION 1
+#define COMPACT_MAX_ALERTS 120 // alerts of one compact message, so it fits in an aggregator batch
+#define COALESCE_COUNT 16 // default number of alerts a node coalesces before sending them
+#define COALESCE_WINDOW 1.0 // default seconds a node holds its oldest alert before sending
+
+
+// Define CompactReportHeader structure, the start of a compact message, stamped when the message is sent
+typedef struct {
+	unsigned char version;
+	unsigned char reserved;
+	unsigned short alertsCount;
+	int reserved2;
+	long timestamp;
+	double commStartTime;
+} CompactReportHeader;
+
+// Define CompactAlert structure, an alert of a compact message in 16 bytes. The coordinates of the reporting node 
+// and its neighbours are derived from its rank in the rows x cols grid, the neighbours present being the bits 
+// of the mask in the order left, right, top and bottom, and every temperature fits in a byte
+typedef struct {
+	int rank;
+	unsigned int age;
+	unsigned char temperature;
+	unsigned char matchCount;
+	unsigned char neighboursMask;
+	unsigned char reserved;
+	unsigned char neighbourTemperatures[MAX_NEIGHBOURS];
+} CompactAlert;
+
+// Define ReportSender structure, to store the alerts a node holds until it sends them, and the counts of what it sent
+typedef struct {
+	MPI_Comm comm;
+	int destination;
+	long timestamp; // time the readings being reported were taken
+	long heldTimestamp; // time the readings of the alerts held were taken, all the same in a finite run
+	char buffer[sizeof(CompactReportHeader) + COMPACT_MAX_ALERTS * sizeof(CompactAlert)];
+	double alertTimes[COMPACT_MAX_ALERTS];
+	int alertsCount;
+	long alertsSent;
+	long messagesSent;
+	long bytesSent;
+} ReportSender;
+
+
+// Function definitions for report.c
+void initAlertType(MPI_Datatype* AlertType);
+void initNodeInfoType(MPI_Datatype* NodeInfoType);
+void initReportType(MPI_Datatype* ReportType);
+int sendReport(MPI_Comm comm, int destination, long timestamp, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount);
+int sendFixedReport(MPI_Comm comm, int destination, long timestamp, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount);
+int unpackReport(MPI_Comm comm, char* reportBuffer, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo);
+int decodeFixedReport(char* reportBuffer, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo);
+void initReportSender(ReportSender* sender, MPI_Comm comm, int destination);
+void submitReport(ReportSender* sender, int matchCount, NodeInfo* nodeInfo, NodeInfo* neighboursNodeInfo, int neighboursCount);
+void flushReports(ReportSender* sender, int force);
+void reportSenderStatistics(MPI_Comm comm, ReportSender* sender);
+int decodeCompactAlert(char* message, int index, Alert* alert, NodeInfo* reportingNode, NodeInfo* neighboursNodeInfo);
+
+#endif
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <mpi.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "./init.h"
+#include "./rng.h"
+
+
+// Philox4x32 multipliers and key increments (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+
+void philox4x32(unsigned int counter[4], unsigned long long seed, unsigned int result[4]) {
+	/**
+	 * Encrypts the counter with the seed as key, giving 4 independent uniformly random words
+	 */
+
+	unsigned int key0 = (unsigned int) seed, key1 = (unsigned int) (seed >> 32);
+	unsigned int x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3];
+	unsigned long long product0, product1;
+	int i;
+
+	for (i = 0; i < RNG_ROUNDS; i++) {
+		product0 = (unsigned long long) PHILOX_M0 * x0;
+		product1 = (unsigned long long) PHILOX_M1 * x2;
+		x0 = (unsigned int) (product1 >> 32) ^ x1 ^ key0;
+		x2 = (unsigned int) (product0 >> 32) ^ x3 ^ key1;
+		x1 = (unsigned int) product1;
+		x3 = (unsigned int) product0;
+		key0 += PHILOX_W0;
+		key1 += PHILOX_W1;
+	}
+	result[0] = x0;
+	result[1] = x1;
+	result[2] = x2;
+	result[3] = x3;
+}
+
+
+// A word is mapped to a temperature by the high half of word * RNG_RANGE (Lemire's multiply-shift), 
+// rejecting the words whose low half is below RNG_THRESHOLD so that every temperature maps from the same number of words
+#define RNG_RANGE (MAX_TEMP - MIN_TEMP + 1)
+#define RNG_THRESHOLD ((unsigned int) ((1ULL << 32) % RNG_RANGE))
+
+
+static inline int mapTemperature(unsigned int word, int* temperature) {
+	/**
+	 * Maps a random word to a temperature, returning 0 if the word is rejected
+	 */
+
+	unsigned long long product = (unsigned long long) word * RNG_RANGE;
+	*temperature = MIN_TEMP + (int) (product >> 32);
+	return (unsigned int) product >= RNG_THRESHOLD;
+}
+
+
+int getRandomNumber(int stream, int index, int iteration) {
+	/**
+	 * Returns the random temperature of an index (a rank or a cell) at an iteration of a stream
+	 */
+
+	unsigned int counter[4] = {(unsigned int) index / RNG_WORDS, (unsigned int) iteration, (unsigned int) stream, 0};
+	unsigned int result[4];
+	int temperature;
+
+	// Move on to the next round of the block while the word is rejected
+	while (1) {
+		philox4x32(counter, randomSeed, result);
+		if (mapTemperature(result[index % RNG_WORDS], &temperature)) return temperature;
+		counter[3]++;
+	}
+}
+
+
+void fillRandomNumbersScalar(int stream, int iteration, int* values, int first, int count) {
+	/**
+	 * Fills the random temperatures of indices first to count-1 (first a multiple of RNG_WORDS) at an iteration of a stream, 
+	 * identical to calling getRandomNumber for each index but with one block for every RNG_WORDS values
+	 */
+
+	unsigned int counter[4] = {0, (unsigned int) iteration, (unsigned int) stream, 0};
+	unsigned int result[4];
+	int i, j;
+
+	for (i = first; i < count; i += RNG_WORDS) {
+		counter[0] = (unsigned int) i / RNG_WORDS;
+		philox4x32(counter, randomSeed, result);
+		for (j = 0; j < RNG_WORDS && i + j < count; j++) {
+			// Rejected words are regenerated from the next rounds like a single value would be
+			if (!mapTemperature(result[j], &values[i + j])) 
+				values[i + j] = getRandomNumber(stream, i + j, iteration);
+		}
+	}
+}
+
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static inline __attribute__((target("avx2"))) void multiplyHighLow(__m256i x, __m256i multiplier, __m256i* high, __m256i* low) {
+	/**
+	 * Multiplies eight 32-bit lanes by a broadcast multiplier into the high and low halves of the 64-bit products
+	 */
+
+	__m256i even = _mm256_mul_epu32(x, multiplier);
+	__m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), multiplier);
+	*low = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+	*high = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+}
+
+
+__attribute__((target("avx2"))) int fillRandomNumbersVector(int stream, int iteration, int* values, int count) {
+	/**
+	 * Fills the random temperatures of the leading multiple of RNG_VECTOR_VALUES indices with AVX2, 
+	 * running eight Philox blocks per lane, and returns how many indices were filled
+	 */
+
+	const __m256i m0 = _mm256_set1_epi32((int) PHILOX_M0), m1 = _mm256_set1_epi32((int) PHILOX_M1);
+	const __m256i range = _mm256_set1_epi32(RNG_RANGE), minTemp = _mm256_set1_epi32(MIN_TEMP);
+	const __m256i sign = _mm256_set1_epi32((int) 0x80000000U);
+	const __m256i threshold = _mm256_set1_epi32((int) (RNG_THRESHOLD ^ 0x80000000U));
+	const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i x[RNG_WORDS], high0, low0, high1, low1, rejected, t0, t1, t2, t3, u0, u1, u2, u3;
+	unsigned int key0, key1;
+	int i, j, w, r, mask;
+	int filled = count - count % RNG_VECTOR_VALUES;
+
+	for (i = 0; i < filled; i += RNG_VECTOR_VALUES) {
+		// Lane k holds block i / RNG_WORDS + k
+		x[0] = _mm256_add_epi32(_mm256_set1_epi32(i / RNG_WORDS), lanes);
+		x[1] = _mm256_set1_epi32(iteration);
+		x[2] = _mm256_set1_epi32(stream);
+		x[3] = _mm256_setzero_si256();
+		key0 = (unsigned int) randomSeed;
+		key1 = (unsigned int) (randomSeed >> 32);
+
+		for (r = 0; r < RNG_ROUNDS; r++) {
+			multiplyHighLow(x[0], m0, &high0, &low0);
+			multiplyHighLow(x[2], m1, &high1, &low1);
+			x[0] = _mm256_xor_si256(_mm256_xor_si256(high1, x[1]), _mm256_set1_epi32((int) key0));
+			x[2] = _mm256_xor_si256(_mm256_xor_si256(high0, x[3]), _mm256_set1_epi32((int) key1));
+			x[1] = low1;
+			x[3] = low0;
+			key0 += PHILOX_W0;
+			key1 += PHILOX_W1;
+		}
+
+		// Map every word to a temperature, remembering the rejected lanes
+		mask = 0;
+		for (w = 0; w < RNG_WORDS; w++) {
+			multiplyHighLow(x[w], range, &high0, &low0);
+			rejected = _mm256_cmpgt_epi32(threshold, _mm256_xor_si256(low0, sign));
+			mask |= _mm256_movemask_ps(_mm256_castsi256_ps(rejected)) << (w * 8);
+			x[w] = _mm256_add_epi32(high0, minTemp);
+		}
+
+		// Transpose the words of the eight blocks into index order
+		t0 = _mm256_unpacklo_epi32(x[0], x[1]);
+		t1 = _mm256_unpackhi_epi32(x[0], x[1]);
+		t2 = _mm256_unpacklo_epi32(x[2], x[3]);
+		t3 = _mm256_unpackhi_epi32(x[2], x[3]);
+		u0 = _mm256_unpacklo_epi64(t0, t2);
+		u1 = _mm256_unpackhi_epi64(t0, t2);
+		u2 = _mm256_unpacklo_epi64(t1, t3);
+		u3 = _mm256_unpackhi_epi64(t1, t3);
+		_mm256_storeu_si256((__m256i*) &values[i], _mm256_permute2x128_si256(u0, u1, 0x20));
+		_mm256_storeu_si256((__m256i*) &values[i + 8], _mm256_permute2x128_si256(u2, u3, 0x20));
+		_mm256_storeu_si256((__m256i*) &values[i + 16], _mm256_permute2x128_si256(u0, u1, 0x31));
+		_mm256_storeu_si256((__m256i*) &values[i + 24], _mm256_permute2x128_si256(u2, u3, 0x31));
+
+		// Regenerate the rare rejected words like a single value would be
+		while (mask) {
+			j = __builtin_ctz(mask);
+			mask &= mask - 1;
+			values[i + (j % 8) * RNG_WORDS + j / 8] = getRandomNumber(stream, i + (j % 8) * RNG_WORDS + j / 8, iteration);
+		}
+	}
+	return filled;
+}
+
+#endif
+
+
+int hasVectorRandomNumbers() {
+	/**
+	 * Returns whether the AVX2 frame kernel can run on this processor
+	 */
+
+#if defined(__x86_64__) || defined(__i386__)
+	static int supported = -1;
+	if (supported < 0) supported = __builtin_cpu_supports("avx2")? 1: 0;
+	return supported;
+#else
+	return 0;
+#endif
+}
+
+
+void fillRandomNumbers(int stream, int iteration, int* values, int count) {
+	/**
+	 * Fills the random temperatures of indices 0 to count-1 at an iteration of a stream, 
+	 * with the AVX2 kernel when the processor supports it and the scalar blocks for the rest
+	 */
+
+	int filled = 0;
+
+#if defined(__x86_64__) || defined(__i386__)
+	if (hasVectorRandomNumbers()) 
+		filled = fillRandomNumbersVector(stream, iteration, values, count);
+#endif
+	fillRandomNumbersScalar(stream, iteration, values, filled, count);
+}
@@ -0,0 +1,26 @@
+#ifndef RNG_H
+#define RNG_H
+
+// Define random number generator constants
+#define RNG_ROUNDS 10 // rounds of Philox4x32, 10 passes the statistical test suites
+#define RNG_WORDS 4 // random words produced by each block
+#define RNG_STREAM_NODE 0 // stream of the temperatures read by the sensor nodes
+#define RNG_STREAM_SATELLITE 1 // stream of the temperatures simulated by the infrared satellite
+#define RNG_VECTOR_VALUES 32 // values filled by each pass of the AVX2 kernel, 8 lanes of blocks of RNG_WORDS
+
+
+// The random numbers are generated by Philox4x32-10, a counter-based generator: every value is a pure function 
+// of (seed, stream, index, iteration), so any process can generate any value without state or communication.
+// The counter of a block is (index / RNG_WORDS, iteration, stream, round), and each of its words gives one value,
+// the round only advances for the rare words rejected to keep the temperatures unbiased.
+// Whole frames are filled by an AVX2 kernel running eight blocks at once, giving the same values as the scalar blocks
+
+// Function definitions for rng.c
+void philox4x32(unsigned int counter[4], unsigned long long seed, unsigned int result[4]);
+int getRandomNumber(int stream, int index, int iteration);
+void fillRandomNumbersScalar(int stream, int iteration, int* values, int first, int count);
+int fillRandomNumbersVector(int stream, int iteration, int* values, int count);
+int hasVectorRandomNumbers();
+void fillRandomNumbers(int stream, int iteration, int* values, int count);
+
+#endif
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "./satellite.h"
+
+
+size_t getSatelliteFileSize(int depth, int size) {
+	/**
+	 * Returns the size in bytes of the ring file of a history
+	 */
+
+	return sizeof(SatelliteHeader) + 2 * (size_t) depth * sizeof(long) + (size_t) depth * size;
+}
+
+
+int initSatelliteHistory(SatelliteHistory* history, char* path, int rows, int cols, int depth, float frameInterval) {
+	/**
+	 * Creates the ring file of an empty history of the given number of frames of rows x cols cells and maps it, 
+	 * returning -1 if the file cannot be created
+	 */
+
+	int slot, fd;
+	size_t mappedSize = getSatelliteFileSize(depth, rows * cols);
+	void* mapping;
+
+	// The file is sized up front, so the frames are never written past its end
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0 || ftruncate(fd, mappedSize) != 0) {
+		perror(path);
+		if (fd >= 0) close(fd);
+		return -1;
+	}
+	mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		perror(path);
+		return -1;
+	}
+
+	SatelliteHeader* header = (SatelliteHeader*) mapping;
+	memcpy(header->magic, SATELLITE_MAGIC, sizeof(header->magic));
+	header->version = SATELLITE_VERSION;
+	header->rows = rows;
+	header->cols = cols;
+	header->depth = depth;
+	header->frameInterval = frameInterval;
+	header->framesCount = 0;
+	mapSatelliteHistory(history, mapping, mappedSize);
+	for (slot = 0; slot < depth; slot++) 
+		history->frameNumbers[slot] = -1;
+	return 0;
+}
+
+
+int openSatelliteHistory(SatelliteHistory* history, char* path) {
+	/**
+	 * Maps the ring file of a history read-only, as it is being written or after, returning -1 if it is not a ring file
+	 */
+
+	int fd;
+	struct stat status;
+	SatelliteHeader header;
+	void* mapping;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+
+	// Check the header before trusting the sizes in it
+	if (read(fd, &header, sizeof(header)) != sizeof(header) || memcmp(header.magic, SATELLITE_MAGIC, sizeof(header.magic)) != 0 
+		|| header.version != SATELLITE_VERSION || fstat(fd, &status) != 0 
+		|| (size_t) status.st_size < getSatelliteFileSize(header.depth, header.rows * header.cols)) {
+		fprintf(stderr, "ERROR: %s is not a version %d satellite ring file\n", path, SATELLITE_VERSION);
+		close(fd);
+		return -1;
+	}
+
+	mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		perror(path);
+		return -1;
+	}
+	mapSatelliteHistory(history, mapping, status.st_size);
+	return 0;
+}
+
+
+void mapSatelliteHistory(SatelliteHistory* history, void* mapping, size_t mappedSize) {
+	/**
+	 * Points the history at the timestamps, numbers and values of the frames in a mapped ring file
+	 */
+
+	history->header = (SatelliteHeader*) mapping;
+	history->depth = history->header->depth;
+	history->size = history->header->rows * history->header->cols;
+	history->timestamps = (long*) (history->header + 1);
+	history->frameNumbers = history->timestamps + history->depth;
+	history->values = (unsigned char*) (history->frameNumbers + history->depth);
+	history->mappedSize = mappedSize;
+}
+
+
+void freeSatelliteHistory(SatelliteHistory* history) {
+	/**
+	 * Unmaps the ring file, which keeps the frames for inspection
+	 */
+
+	munmap(history->header, history->mappedSize);
+}
+
+
+void publishFrame(SatelliteHistory* history, long timestamp, int* values) {
+	/**
+	 * Replaces the oldest frame with the given one, only called by the satellite thread
+	 */
+
+	int j;
+	long frame = history->header->framesCount;
+	int slot = frame % history->depth;
+	unsigned char* value = history->values + (size_t) slot * history->size;
+
+	// Mark the slot as being written before any of its data changes
+	__atomic_store_n(&history->frameNumbers[slot], -1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	__atomic_store_n(&history->timestamps[slot], timestamp, __ATOMIC_RELAXED);
+	for (j = 0; j < history->size; j++) 
+		__atomic_store_n(&value[j], (unsigned char) values[j], __ATOMIC_RELAXED);
+
+	// Publish the frame once all of its data is written
+	__atomic_store_n(&history->frameNumbers[slot], frame, __ATOMIC_RELEASE);
+	__atomic_store_n(&history->header->framesCount, frame + 1, __ATOMIC_RELEASE);
+}
+
+
+int readFrameValue(SatelliteHistory* history, long frame, int index, long* timestamp, int* value) {
+	/**
+	 * Reads the timestamp of a frame and its temperature at the index (if the index is not negative), 
+	 * returning false if the frame has been overwritten by a newer one
+	 */
+
+	int slot = frame % history->depth;
+
+	if (__atomic_load_n(&history->frameNumbers[slot], __ATOMIC_ACQUIRE) != frame) return 0;
+	*timestamp = __atomic_load_n(&history->timestamps[slot], __ATOMIC_RELAXED);
+	if (index >= 0) 
+		*value = __atomic_load_n(&history->values[(size_t) slot * history->size + index], __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&history->frameNumbers[slot], __ATOMIC_RELAXED) == frame;
+}
+
+
+long findFrame(SatelliteHistory* history, long first, long end, long since) {
+	/**
+	 * Binary searches the frames from first to end (excluded) for the first one taken at or after the given time. 
+	 * The timestamps never decrease from frame to frame, and an overwritten frame counts as older than any
+	 */
+
+	long middle, timestamp;
+
+	while (first < end) {
+		middle = first + (end - first) / 2;
+		if (!readFrameValue(history, middle, -1, &timestamp, NULL) || timestamp < since) first = middle + 1;
+		else end = middle;
+	}
+	return first;
+}
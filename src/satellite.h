@@ -0,0 +1,54 @@
+#ifndef SATELLITE_H
+#define SATELLITE_H
+
+#include <stddef.h>
+
+// Define satellite constants
+#define SATELLITE_MAGIC "WSNFRAME"
+#define SATELLITE_VERSION 2
+#define SATELLITE_FILE "satellite_frames.bin" // default ring file of the satellite frames
+
+
+// Define SatelliteHeader structure, at the start of the ring file, so any tool can find the frames in it
+typedef struct {
+	char magic[8];
+	int version;
+	int rows;
+	int cols;
+	int depth;
+	float frameInterval;
+	int reserved;
+	long framesCount; // frames published so far, the next is written over frame framesCount - depth
+} __attribute__((aligned(64))) SatelliteHeader;
+
+// Define SatelliteHistory structure, a ring of the latest frames of the infrared satellite, mapped from a file and 
+// laid out for lookups by time. After the header, the file holds the timestamps of the frames, their numbers, then 
+// the values of each frame in one contiguous slot (frame-major). So a lookup binary searches the small time index for 
+// the frames within TIME_WINDOW of an alert, then reads the value of its cell in each of them. 
+// A cell costs 1 byte per frame, and each frame 16 bytes more for its timestamp and number, so a history of 
+// depth frames over n cells takes depth * (n + 16) bytes of disk. Publishing a frame only writes its own slot, so the 
+// pages of the older frames stay clean and the kernel may drop them, and only the latest frames need to stay in memory.
+// The satellite thread is the sole writer, overwriting the oldest frame: a frame's number is -1 while it is rewritten, 
+// and readers check it is unchanged around their read, so they never block the satellite thread
+typedef struct {
+	SatelliteHeader* header;
+	int depth;
+	int size;
+	long* timestamps;
+	long* frameNumbers;
+	unsigned char* values;
+	size_t mappedSize;
+} SatelliteHistory;
+
+
+// Function definitions for satellite.c
+size_t getSatelliteFileSize(int depth, int size);
+int initSatelliteHistory(SatelliteHistory* history, char* path, int rows, int cols, int depth, float frameInterval);
+int openSatelliteHistory(SatelliteHistory* history, char* path);
+void mapSatelliteHistory(SatelliteHistory* history, void* mapping, size_t mappedSize);
+void freeSatelliteHistory(SatelliteHistory* history);
+void publishFrame(SatelliteHistory* history, long timestamp, int* values);
+int readFrameValue(SatelliteHistory* history, long frame, int index, long* timestamp, int* value);
+long findFrame(SatelliteHistory* history, long first, long end, long since);
+
+#endif
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "./satellite.h"
+
+
+int main(int argc, char *argv[]) {
+	/**
+	 * Prints the frames kept in a satellite ring file, during or after a run: the header and the time of every frame, 
+	 * or the temperature of every sensor of one frame
+	 */
+
+	int i, j, value;
+	long frame, timestamp, first, end;
+	time_t frameTime;
+	char timeString[32];
+	SatelliteHistory history;
+
+	if (argc != 2 && argc != 3) {
+		printf("HELPER: satview <satellite_frames.bin> [frame]\n");
+		return 1;
+	}
+	if (openSatelliteHistory(&history, argv[1]) != 0) return 1;
+
+	// Only the latest frames are kept, up to the depth of the ring
+	end = __atomic_load_n(&history.header->framesCount, __ATOMIC_ACQUIRE);
+	first = end > history.depth? end - history.depth: 0;
+	printf("Grid: (%d x %d), frame interval: %.3fs, depth: %d frames\n", history.header->rows, history.header->cols, history.header->frameInterval, history.depth);
+	printf("Frames: %ld published, %ld to %ld kept\n", end, first, end - 1);
+
+	if (argc == 2) {
+		for (frame = first; frame < end; frame++) {
+			if (!readFrameValue(&history, frame, -1, &timestamp, NULL)) continue; // overwritten meanwhile
+			frameTime = timestamp;
+			strftime(timeString, sizeof(timeString), "%a %Y-%m-%d %H:%M:%S", localtime(&frameTime));
+			printf("FRAME[%ld] = %s\n", frame, timeString);
+		}
+		freeSatelliteHistory(&history);
+		return 0;
+	}
+
+	// Print the temperatures of the frame as the grid
+	frame = strtol(argv[2], NULL, 10);
+	if (frame < first || frame >= end || !readFrameValue(&history, frame, -1, &timestamp, NULL)) {
+		fprintf(stderr, "ERROR: frame %ld is not kept in %s\n", frame, argv[1]);
+		freeSatelliteHistory(&history);
+		return 1;
+	}
+	frameTime = timestamp;
+	strftime(timeString, sizeof(timeString), "%a %Y-%m-%d %H:%M:%S", localtime(&frameTime));
+	printf("FRAME[%ld] = %s\n", frame, timeString);
+	for (i = 0; i < history.header->rows; i++) {
+		for (j = 0; j < history.header->cols; j++) {
+			if (!readFrameValue(&history, frame, i * history.header->cols + j, &timestamp, &value)) {
+				fprintf(stderr, "ERROR: frame %ld was overwritten while it was read\n", frame);
+				freeSatelliteHistory(&history);
+				return 1;
+			}
+			printf("%4d", value);
+		}
+		printf("\n");
+	}
+	freeSatelliteHistory(&history);
+	return 0;
+}
@@ -0,0 +1,38 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <time.h>
+
+#include "./init.h"
+#include "./simclock.h"
+
+
+long getSimulatedTime(double elapsed) {
+	/**
+	 * Returns the time of an event happening the given simulated seconds into the run. On the virtual clock, it is counted 
+	 * from the start of the run, so it only depends on the order of events, and otherwise it is the wall clock time
+	 */
+
+	if (isVirtualClock()) 
+		return clockStartTime + (long) elapsed;
+	return (long) time(NULL);
+}
+
+
+void advanceClock(double seconds) {
+	/**
+	 * Lets the given simulated seconds pass, sleeping on the wall clock but at once on the virtual clock
+	 */
+
+	if (isVirtualClock() || seconds <= 0) return;
+	struct timespec delay = {(time_t) seconds, (long) ((seconds - (time_t) seconds) * 1e9)};
+	nanosleep(&delay, NULL);
+}
+
+
+int isVirtualClock() {
+	/**
+	 * Returns true if the run is paced by the virtual clock
+	 */
+
+	return virtualHorizon > 0;
+}
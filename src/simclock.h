@@ -0,0 +1,14 @@
+#ifndef SIMCLOCK_H
+#define SIMCLOCK_H
+
+// Define simulated clock constants
+#define VIRTUAL_SYNC_INTERVAL TIME_WINDOW // simulated seconds the nodes may run apart on the virtual clock before they wait for each other
+#define VIRTUAL_HISTORY_WINDOWS 4 // time windows of satellite frames the base station keeps on the virtual clock, to cover the nodes running apart
+
+
+// Function definitions for simclock.c
+long getSimulatedTime(double elapsed);
+void advanceClock(double seconds);
+int isVirtualClock();
+
+#endif
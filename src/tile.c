@@ -0,0 +1,518 @@
+#include <stdio.h>
+#include <mpi.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "./init.h"
+#include "./node.h"
+#include "./tile.h"
+#include "./rng.h"
+#include "./record.h"
+#include "./simclock.h"
+
+
+void tile(MPI_Comm commWorld, MPI_Comm comm) {
+	/**
+	 * Runs the event detection for a tile of sensors in lockstep with the neighbouring tiles
+	 * 
+	 * commWorld: communication for entire program, to enable communication with base station
+	 * comm: communication for the node ranks
+	 */
+
+	/*******************************************************
+	 * Setting up cartesian grid topology of the tiles
+	 ********************************************************/
+
+	int rank, i, count = 0;
+	MPI_Comm cartComm;
+	MPI_Comm_rank(comm, &rank);
+	initCartesianTopology(comm, tileGrid[0], tileGrid[1], &cartComm);
+
+	// Opening a binary trace, decoded into the text log by tracedump
+	TraceBuffer trace;
+	openTrace(&trace, rank);
+
+	// Let the base station measure this rank's clock offset, then send it the MAC and IP addresses
+	synchronizeClocks(commWorld);
+	shareAddress(&trace, commWorld);
+
+	// Find the sensors of this tile and pre-post the halo exchange and termination receive
+	Tile tile;
+	initTile(&tile, commWorld, cartComm, rank);
+
+	// Share the rows of the tile among the worker threads, if any
+	if (workerThreads > 0) 
+		startTileWorkers(&tile, workerThreads);
+
+	// Logging the neighbouring tiles, by the coordinates of their first sensor
+	int tileCoord[N_DIMS], origin[N_DIMS], size[N_DIMS];
+	for (i = 0; i < tile.haloNeighboursCount; i++) {
+		MPI_Cart_coords(cartComm, tile.haloNeighbours[i], N_DIMS, tileCoord);
+		getTileBounds(tileCoord, origin, size);
+		traceEvent(&trace, TRACE_NEIGHBOUR, tile.haloNeighbours[i], ((long long) origin[0] << 32) | (unsigned int) origin[1]);
+	}
+
+	// Initialize the halo exchange latencies
+	Histogram latencies;
+	initHistogram(&latencies, HISTOGRAM_PRECISION);
+	double exchangeStartTime;
+
+	// Record the readings of the tile, or read them back from a recording
+	RecordFile record;
+	int cellsCount = tile.size[0] * tile.size[1], iterationsCount = INT_MAX, flag;
+	int* sensors = &tile.temperatures[tile.stride + 1];
+	long timestamp, replayCount;
+	if (recordPrefix != NULL && openRecord(&record, recordPrefix, rank, cellsCount) != 0) 
+		MPI_Abort(commWorld, 1);
+	if (replayPrefix != NULL) {
+		if (openReplay(&record, replayPrefix, rank, cellsCount) != 0) 
+			MPI_Abort(commWorld, 1);
+		MPI_Allreduce(&record.samplesCount, &replayCount, 1, MPI_LONG, MPI_MIN, comm);
+		iterationsCount = (int) replayCount;
+	}
+
+	// On the virtual clock, every tile runs the iterations up to the horizon, in step as they agree on termination every iteration
+	if (isVirtualClock()) 
+		iterationsCount = (int) (virtualHorizon / nodeInterval);
+
+	printf("Node %d started executing a tile of %d x %d sensors from (%d, %d)\n", rank, tile.size[0], tile.size[1], tile.origin[0], tile.origin[1]);
+
+	// Wait 3 seconds for infrared simulation to be populated, unless the frames are replayed
+	if (replayPrefix == NULL) 
+		advanceClock(NODE_DELAYS);
+
+
+	/*******************************************************
+	 * Simulate the sensor readings of the tile
+	 *******************************************************/
+
+	// Keep running until every tile has received the termination signal, or has replayed every reading or reached the horizon
+	while (!tile.terminated && count < iterationsCount) {
+		tile.iteration = count;
+		if (replayPrefix != NULL) 
+			readRecord(&record, &timestamp, sensors, tile.size[1], tile.stride);
+		else {
+			timestamp = getSimulatedTime(NODE_DELAYS + count * nodeInterval);
+			if (tile.workersCount > 0) runTilePhase(&tile, TILE_PHASE_GENERATE);
+			else generateTileTemperatures(&tile, count, 0, tile.size[0]);
+			if (recordPrefix != NULL) 
+				writeRecord(&record, timestamp, sensors, tile.size[1], tile.stride);
+		}
+		tile.sender.timestamp = timestamp;
+
+		// Exchange the edge sensors with the neighbouring tiles
+		exchangeStartTime = MPI_Wtime();
+		exchangeHalo(&tile);
+		recordValue(&latencies, (long long) ((MPI_Wtime() - exchangeStartTime) * 1e9));
+
+		// Match every hot sensor with its neighbours and report the alerts, sending the reports the workers queue meanwhile
+		if (tile.workersCount > 0) runTilePhase(&tile, TILE_PHASE_CHECK);
+		else checkTileSensors(&tile, 0, tile.size[0], NULL);
+
+		// Send the alerts held for the coalescing window
+		flushReports(&tile.sender, 0);
+
+		// Stop together with the neighbouring tiles, as each iteration waits on their halos
+		checkTileTermination(&tile);
+		if (tile.terminated) continue;
+
+		// Let the iteration interval pass
+		advanceClock(nodeInterval);
+
+		// Increase the iteration count (for randomizing number generation)
+		count++;
+	}
+
+	// Tell the base station this tile is done after its last report, with an empty report, then wait for termination
+	if (finiteRun && !tile.terminated) {
+		flushReports(&tile.sender, 1);
+		MPI_Send(NULL, 0, MPI_BYTE, 0, REPORT_TAG, reportComm);
+		MPI_Test(&tile.terminationRequest, &flag, MPI_STATUS_IGNORE);
+		while (!flag) {
+			usleep(BASE_POLL_INTERVAL);
+			MPI_Test(&tile.terminationRequest, &flag, MPI_STATUS_IGNORE);
+		}
+		tile.terminated = 1;
+	}
+	if (recordPrefix != NULL || replayPrefix != NULL) 
+		closeRecord(&record);
+
+	if (tile.workersCount > 0) 
+		stopTileWorkers(&tile);
+
+	// Summarize the halo exchange statistics and resource usage of all tiles
+	reportTileStatistics(comm, &tile, &latencies, count);
+	reportSenderStatistics(comm, &tile.sender);
+	freeHistogram(&latencies);
+	reportResourceUsage(comm, "Node", (long) tile.size[0] * tile.size[1]);
+	sumCPUTime(commWorld);
+
+	printf("Node %d terminated\n", rank);
+
+	// Write the remaining trace events out
+	closeTrace(&trace);
+
+	freeTile(&tile);
+	MPI_Comm_free(&cartComm);
+}
+
+
+int getTileGrid(int processes, int tileGrid[N_DIMS]) {
+	/**
+	 * Chooses the grid of tiles for the given number of node ranks, the one with the shortest tile edges (and so 
+	 * the fewest halo cells) among those where every tile has at least one sensor. Returns -1 if there is none
+	 */
+
+	int tileRows, tileCols;
+	double edges, shortestEdges = -1;
+
+	for (tileRows = 1; tileRows <= processes; tileRows++) {
+		if (processes % tileRows != 0) continue;
+		tileCols = processes / tileRows;
+		if (tileRows > rows || tileCols > cols) continue;
+
+		edges = (double) rows / tileRows + (double) cols / tileCols;
+		if (shortestEdges < 0 || edges < shortestEdges) {
+			shortestEdges = edges;
+			tileGrid[0] = tileRows;
+			tileGrid[1] = tileCols;
+		}
+	}
+	return shortestEdges < 0? -1: 0;
+}
+
+
+void getTileBounds(int tileCoord[N_DIMS], int origin[N_DIMS], int size[N_DIMS]) {
+	/**
+	 * Gets the coordinates of the first sensor and the number of sensor rows and columns of a tile, 
+	 * splitting the rows and columns of the sensor grid as evenly as possible
+	 */
+
+	int extent[N_DIMS] = {rows, cols}, i;
+
+	for (i = 0; i < N_DIMS; i++) {
+		origin[i] = (int) ((long) tileCoord[i] * extent[i] / tileGrid[i]);
+		size[i] = (int) ((long) (tileCoord[i] + 1) * extent[i] / tileGrid[i]) - origin[i];
+	}
+}
+
+
+int getSensorOwner(int sensor) {
+	/**
+	 * Returns the node rank simulating a sensor, which is the sensor itself unless running tiled
+	 */
+
+	int row = sensor / cols, col = sensor % cols;
+
+	// Invert the even split of getTileBounds
+	int tileRow = (int) (((long) (row + 1) * tileGrid[0] - 1) / rows);
+	int tileCol = (int) (((long) (col + 1) * tileGrid[1] - 1) / cols);
+	return tileRow * tileGrid[1] + tileCol;
+}
+
+
+void initTile(Tile* tile, MPI_Comm commWorld, MPI_Comm cartComm, int rank) {
+	/**
+	 * Allocates the sensors of this rank's tile and pre-posts the halo exchange with the neighbouring tiles 
+	 * as persistent requests, and the receive of the termination signal from the base station
+	 */
+
+	int i, leftRank, rightRank, topRank, bottomRank;
+
+	tile->commWorld = commWorld;
+	tile->cartComm = cartComm;
+	tile->terminated = 0;
+	tile->messagesSent = 0;
+	tile->reportsSent = 0;
+	initReportSender(&tile->sender, reportComm, 0);
+	tile->workers = NULL;
+	tile->workersCount = 0;
+
+	MPI_Cart_coords(cartComm, rank, N_DIMS, tile->coord);
+	getTileBounds(tile->coord, tile->origin, tile->size);
+	tile->stride = tile->size[1] + 2;
+	tile->temperatures = (int*) calloc((tile->size[0] + 2) * tile->stride, sizeof(int));
+
+	// A column of the tile is strided by a whole row of the halo-padded array
+	MPI_Type_vector(tile->size[0], 1, tile->stride, MPI_INT, &tile->columnType);
+	MPI_Type_commit(&tile->columnType);
+
+	MPI_Cart_shift(cartComm, SHIFT_ROW, DISP, &topRank, &bottomRank);
+	MPI_Cart_shift(cartComm, SHIFT_COL, DISP, &leftRank, &rightRank);
+
+	// Send the edge sensors to each neighbouring tile and receive theirs into the halo
+	int* t = tile->temperatures;
+	int lastRow = tile->size[0], lastCol = tile->size[1], stride = tile->stride;
+	MPI_Send_init(&t[stride + 1], 1, tile->columnType, leftRank, HALO_TAG, cartComm, &tile->haloRequests[0]);
+	MPI_Recv_init(&t[stride], 1, tile->columnType, leftRank, HALO_TAG, cartComm, &tile->haloRequests[1]);
+	MPI_Send_init(&t[stride + lastCol], 1, tile->columnType, rightRank, HALO_TAG, cartComm, &tile->haloRequests[2]);
+	MPI_Recv_init(&t[stride + lastCol + 1], 1, tile->columnType, rightRank, HALO_TAG, cartComm, &tile->haloRequests[3]);
+	MPI_Send_init(&t[stride + 1], lastCol, MPI_INT, topRank, HALO_TAG, cartComm, &tile->haloRequests[4]);
+	MPI_Recv_init(&t[1], lastCol, MPI_INT, topRank, HALO_TAG, cartComm, &tile->haloRequests[5]);
+	MPI_Send_init(&t[lastRow * stride + 1], lastCol, MPI_INT, bottomRank, HALO_TAG, cartComm, &tile->haloRequests[6]);
+	MPI_Recv_init(&t[(lastRow + 1) * stride + 1], lastCol, MPI_INT, bottomRank, HALO_TAG, cartComm, &tile->haloRequests[7]);
+
+	// Keep the valid neighbouring tiles, in the order of getValidNeighbours
+	int allNeighbours[4] = {leftRank, rightRank, topRank, bottomRank};
+	tile->haloNeighboursCount = 0;
+	for (i = 0; i < 4; i++) {
+		if (allNeighbours[i] >= 0) tile->haloNeighbours[tile->haloNeighboursCount++] = allNeighbours[i];
+	}
+
+	listenForTermination(&tile->terminationBuffer, &tile->terminationRequest);
+}
+
+
+void generateTileTemperatures(Tile* tile, int iteration, int firstRow, int lastRow) {
+	/**
+	 * Reads the temperature of every sensor in rows firstRow to lastRow-1 of the tile, from the node stream of its global sensor rank
+	 */
+
+	int i, j, sensor;
+
+	for (i = firstRow; i < lastRow; i++) {
+		sensor = (tile->origin[0] + i) * cols + tile->origin[1];
+		for (j = 0; j < tile->size[1]; j++) 
+			tile->temperatures[(i + 1) * tile->stride + j + 1] = getRandomNumber(RNG_STREAM_NODE, sensor + j, iteration);
+	}
+}
+
+
+void exchangeHalo(Tile* tile) {
+	/**
+	 * Exchanges the edge sensors with the neighbouring tiles and waits for their edges to fill the halo
+	 */
+
+	MPI_Startall(4 * 2, tile->haloRequests);
+	MPI_Waitall(4 * 2, tile->haloRequests, MPI_STATUSES_IGNORE);
+	tile->messagesSent += tile->haloNeighboursCount;
+}
+
+
+void checkTileSensors(Tile* tile, int firstRow, int lastRow, ReportQueue* queue) {
+	/**
+	 * Matches every hot sensor in rows firstRow to lastRow-1 of the tile with its neighbours inside the tile or in the halo, 
+	 * and sends a report with the global sensor ranks and coordinates for each alert, or queues it for the MPI thread
+	 */
+
+	int i, j, row, col, index, neighboursCount, matchCount;
+	int* t = tile->temperatures;
+	NodeInfo nodeInfo, neighboursNodeInfo[MAX_NEIGHBOURS];
+	TileReport* report;
+
+	for (i = firstRow; i < lastRow; i++) {
+		for (j = 0; j < tile->size[1]; j++) {
+			index = (i + 1) * tile->stride + j + 1;
+			if (t[index] <= THRESHOLD) continue;
+
+			row = tile->origin[0] + i;
+			col = tile->origin[1] + j;
+			nodeInfo.rank = row * cols + col;
+			nodeInfo.coord[0] = row;
+			nodeInfo.coord[1] = col;
+			nodeInfo.temperature = t[index];
+
+			// Gather the neighbours inside the sensor grid, left, right, top and bottom
+			neighboursCount = 0;
+			if (col > 0) 
+				neighboursNodeInfo[neighboursCount++] = (NodeInfo) {nodeInfo.rank - 1, {row, col - 1}, t[index - 1]};
+			if (col < cols - 1) 
+				neighboursNodeInfo[neighboursCount++] = (NodeInfo) {nodeInfo.rank + 1, {row, col + 1}, t[index + 1]};
+			if (row > 0) 
+				neighboursNodeInfo[neighboursCount++] = (NodeInfo) {nodeInfo.rank - cols, {row - 1, col}, t[index - tile->stride]};
+			if (row < rows - 1) 
+				neighboursNodeInfo[neighboursCount++] = (NodeInfo) {nodeInfo.rank + cols, {row + 1, col}, t[index + tile->stride]};
+
+			matchCount = getMatchingCount(neighboursNodeInfo, nodeInfo.temperature, neighboursCount);
+			if (matchCount < 2) continue;
+
+			if (queue == NULL) {
+				submitReport(&tile->sender, matchCount, &nodeInfo, neighboursNodeInfo, neighboursCount);
+				tile->reportsSent++;
+				continue;
+			}
+
+			// Wait for the MPI thread to free a slot, then publish the report
+			while (queue->head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == TILE_QUEUE_CAPACITY) 
+				sched_yield();
+			report = &queue->reports[queue->head % TILE_QUEUE_CAPACITY];
+			report->matchCount = matchCount;
+			report->nodeInfo = nodeInfo;
+			report->neighboursCount = neighboursCount;
+			memcpy(report->neighboursNodeInfo, neighboursNodeInfo, neighboursCount * sizeof(NodeInfo));
+			__atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+		}
+	}
+}
+
+
+void startTileWorkers(Tile* tile, int workersCount) {
+	/**
+	 * Starts the worker threads, each simulating an even share of the rows of the tile with its own report queue
+	 */
+
+	int i;
+
+	tile->workersCount = workersCount;
+	tile->workers = (TileWorker*) malloc(workersCount * sizeof(TileWorker));
+	pthread_barrier_init(&tile->phaseBarrier, NULL, workersCount + 1);
+
+	for (i = 0; i < workersCount; i++) {
+		TileWorker* worker = &tile->workers[i];
+		worker->tile = tile;
+		worker->firstRow = (int) ((long) i * tile->size[0] / workersCount);
+		worker->lastRow = (int) ((long) (i + 1) * tile->size[0] / workersCount);
+		worker->queue = (ReportQueue*) malloc(sizeof(ReportQueue));
+		worker->queue->head = 0;
+		worker->queue->tail = 0;
+		pthread_create(&worker->tid, NULL, threadTileWorker, worker);
+	}
+}
+
+
+void* threadTileWorker(void* arg) {
+	/**
+	 * Runs each phase of an iteration on the rows of a worker, between the barriers of the MPI thread. 
+	 * Worker threads make no MPI calls
+	 */
+
+	TileWorker* worker = (TileWorker*) arg;
+	Tile* tile = worker->tile;
+
+	while (1) {
+		pthread_barrier_wait(&tile->phaseBarrier);
+		if (tile->phase == TILE_PHASE_STOP) break;
+
+		if (tile->phase == TILE_PHASE_GENERATE) {
+			generateTileTemperatures(tile, tile->iteration, worker->firstRow, worker->lastRow);
+		} else {
+			checkTileSensors(tile, worker->firstRow, worker->lastRow, worker->queue);
+			__atomic_add_fetch(&tile->workersDone, 1, __ATOMIC_RELEASE);
+		}
+		pthread_barrier_wait(&tile->phaseBarrier);
+	}
+	return NULL;
+}
+
+
+void runTilePhase(Tile* tile, int phase) {
+	/**
+	 * Runs a phase on all worker threads and returns once they have finished it. While they check the sensors, 
+	 * the MPI thread sends the reports they queue
+	 */
+
+	tile->phase = phase;
+	tile->workersDone = 0;
+	pthread_barrier_wait(&tile->phaseBarrier);
+	if (phase == TILE_PHASE_STOP) return;
+
+	if (phase == TILE_PHASE_CHECK) {
+		while (__atomic_load_n(&tile->workersDone, __ATOMIC_ACQUIRE) < tile->workersCount) {
+			if (sendQueuedReports(tile) == 0) sched_yield();
+		}
+		sendQueuedReports(tile);
+	}
+	pthread_barrier_wait(&tile->phaseBarrier);
+}
+
+
+int sendQueuedReports(Tile* tile) {
+	/**
+	 * Sends the reports queued by every worker thread to the base station and returns how many were sent
+	 */
+
+	int i, sent = 0;
+	unsigned long head;
+	ReportQueue* queue;
+	TileReport* report;
+
+	for (i = 0; i < tile->workersCount; i++) {
+		queue = tile->workers[i].queue;
+		head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+		while (queue->tail < head) {
+			report = &queue->reports[queue->tail % TILE_QUEUE_CAPACITY];
+			submitReport(&tile->sender, report->matchCount, &report->nodeInfo, report->neighboursNodeInfo, report->neighboursCount);
+			__atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+			sent++;
+		}
+	}
+	tile->reportsSent += sent;
+	return sent;
+}
+
+
+void stopTileWorkers(Tile* tile) {
+	/**
+	 * Stops and joins the worker threads and frees their queues
+	 */
+
+	int i;
+
+	runTilePhase(tile, TILE_PHASE_STOP);
+	for (i = 0; i < tile->workersCount; i++) {
+		pthread_join(tile->workers[i].tid, NULL);
+		free(tile->workers[i].queue);
+	}
+	pthread_barrier_destroy(&tile->phaseBarrier);
+	free(tile->workers);
+	tile->workersCount = 0;
+}
+
+
+void checkTileTermination(Tile* tile) {
+	/**
+	 * Checks for the termination signal, agreeing with all tiles so that none waits on the halo of a stopped tile
+	 */
+
+	int flag;
+
+	MPI_Test(&tile->terminationRequest, &flag, MPI_STATUS_IGNORE);
+	MPI_Allreduce(&flag, &tile->terminated, 1, MPI_INT, MPI_MAX, tile->cartComm);
+
+	// Consume the signal if another tile saw it first
+	if (tile->terminated && !flag) 
+		MPI_Wait(&tile->terminationRequest, MPI_STATUS_IGNORE);
+}
+
+
+void freeTile(Tile* tile) {
+	/**
+	 * Frees the halo exchange requests and the sensors of the tile
+	 */
+
+	int i;
+
+	for (i = 0; i < 4 * 2; i++) 
+		MPI_Request_free(&tile->haloRequests[i]);
+	MPI_Type_free(&tile->columnType);
+	free(tile->temperatures);
+}
+
+
+void reportTileStatistics(MPI_Comm comm, Tile* tile, Histogram* latencies, int iterations) {
+	/**
+	 * Sums the halo exchange statistics of all tiles and prints the messages, reports and halo exchange latency
+	 */
+
+	int rank;
+	long counts[3] = {tile->messagesSent, tile->reportsSent, (long) tile->size[0] * tile->size[1]};
+	long totalCounts[3];
+	Histogram totalLatencies;
+	initHistogram(&totalLatencies, latencies->precision);
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Reduce(counts, totalCounts, 3, MPI_LONG, MPI_SUM, 0, comm);
+	reduceHistogram(latencies, &totalLatencies, 0, comm);
+
+	if (rank == 0) {
+		printf("Tiles: %ld sensors, %d iterations, %ld halo messages, %ld reports sent\n", totalCounts[2], iterations, totalCounts[0], totalCounts[1]);
+		printLatencyPercentiles("halo exchange", &totalLatencies);
+		fflush(stdout);
+	}
+	freeHistogram(&totalLatencies);
+}
@@ -0,0 +1,93 @@
+#ifndef TILE_H
+#define TILE_H
+
+#include <pthread.h>
+
+#include "./trace.h"
+#include "./histogram.h"
+#include "./report.h"
+
+// Define tile constants
+#define TILE_QUEUE_CAPACITY 1024 // reports a worker thread can queue before it waits for the MPI thread
+#define TILE_PHASE_GENERATE 0 // worker threads read the temperatures of their rows
+#define TILE_PHASE_CHECK 1 // worker threads match the hot sensors of their rows and queue the reports
+#define TILE_PHASE_STOP 2 // worker threads exit
+
+
+// Define TileReport structure, to store a report queued by a worker thread for the MPI thread to send
+typedef struct {
+	int matchCount;
+	NodeInfo nodeInfo;
+	int neighboursCount;
+	NodeInfo neighboursNodeInfo[MAX_NEIGHBOURS];
+} TileReport;
+
+// Define ReportQueue structure, a lock-free single producer (worker thread) single consumer (MPI thread) ring of reports.
+// The head is only advanced by the worker and the tail only by the MPI thread, each publishing with release stores
+typedef struct {
+	TileReport reports[TILE_QUEUE_CAPACITY];
+	unsigned long head __attribute__((aligned(64)));
+	unsigned long tail __attribute__((aligned(64)));
+} ReportQueue;
+
+struct Tile;
+
+// Define TileWorker structure, to store the rows of a tile simulated by a worker thread
+typedef struct {
+	struct Tile* tile;
+	int firstRow;
+	int lastRow;
+	ReportQueue* queue;
+	pthread_t tid;
+} TileWorker;
+
+// Define Tile structure, to store the rectangular block of sensors simulated by a node rank in tiled mode.
+// The temperatures are kept row-major with a halo of one cell on every side, holding the edge sensors of 
+// the neighbouring tiles, so matching a sensor with its neighbours is plain memory access inside the tile.
+// With worker threads, the MPI thread runs each phase of an iteration on all workers between two barriers
+typedef struct Tile {
+	MPI_Comm commWorld;
+	MPI_Comm cartComm;
+	int coord[N_DIMS];
+	int origin[N_DIMS];
+	int size[N_DIMS];
+	int stride;
+	int* temperatures;
+	MPI_Datatype columnType;
+	MPI_Request haloRequests[4 * 2];
+	int haloNeighbours[4];
+	int haloNeighboursCount;
+	MPI_Request terminationRequest;
+	int terminationBuffer;
+	int terminated;
+	long messagesSent;
+	long reportsSent;
+	ReportSender sender;
+	TileWorker* workers;
+	int workersCount;
+	pthread_barrier_t phaseBarrier;
+	int phase;
+	int iteration;
+	int workersDone;
+} Tile;
+
+
+// Function definitions for tile.c
+void tile(MPI_Comm commWorld, MPI_Comm comm);
+int getTileGrid(int processes, int tileGrid[N_DIMS]);
+void getTileBounds(int tileCoord[N_DIMS], int origin[N_DIMS], int size[N_DIMS]);
+int getSensorOwner(int sensor);
+void initTile(Tile* tile, MPI_Comm commWorld, MPI_Comm cartComm, int rank);
+void generateTileTemperatures(Tile* tile, int iteration, int firstRow, int lastRow);
+void exchangeHalo(Tile* tile);
+void checkTileSensors(Tile* tile, int firstRow, int lastRow, ReportQueue* queue);
+void startTileWorkers(Tile* tile, int workersCount);
+void* threadTileWorker(void* arg);
+void runTilePhase(Tile* tile, int phase);
+int sendQueuedReports(Tile* tile);
+void stopTileWorkers(Tile* tile);
+void checkTileTermination(Tile* tile);
+void freeTile(Tile* tile);
+void reportTileStatistics(MPI_Comm comm, Tile* tile, Histogram* latencies, int iterations);
+
+#endif
@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./trace.h"
+
+
+void openTrace(TraceBuffer* trace, int rank) {
+	/**
+	 * Opens the binary trace file of a rank and allocates its in-memory buffer
+	 */
+
+	char filename[50];
+	TraceHeader header;
+
+	sprintf(filename, "trace_%d.bin", rank);
+	trace->fptr = fopen(filename, "wb");
+	trace->events = (TraceEvent*) malloc(TRACE_BUFFER_EVENTS * sizeof(TraceEvent));
+	trace->count = 0;
+
+	memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+	header.version = TRACE_VERSION;
+	header.rank = rank;
+	fwrite(&header, sizeof(TraceHeader), 1, trace->fptr);
+}
+
+
+void flushTrace(TraceBuffer* trace) {
+	/**
+	 * Writes the buffered events out in one chunk
+	 */
+
+	fwrite(trace->events, sizeof(TraceEvent), trace->count, trace->fptr);
+	trace->count = 0;
+}
+
+
+void closeTrace(TraceBuffer* trace) {
+	/**
+	 * Writes the remaining events out and closes the trace file
+	 */
+
+	flushTrace(trace);
+	fclose(trace->fptr);
+	free(trace->events);
+}
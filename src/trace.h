@@ -0,0 +1,73 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <time.h>
+
+// Define trace constants
+#define TRACE_MAGIC "WSNTRACE"
+#define TRACE_VERSION 1
+#define TRACE_BUFFER_EVENTS 65536 // events buffered in memory before they are written out in one chunk
+
+
+// Define trace event types, each one replaces a line of the node's text log
+#define TRACE_MAC_ADDRESS 0 // value: MAC address, 6 bytes big endian
+#define TRACE_IP_ADDRESS 1 // value: IPv4 address in network order, or -1 if unknown
+#define TRACE_NEIGHBOUR 2 // peer: neighbour rank, value: row << 32 | column
+#define TRACE_TEMPERATURE 3 // value: temperature
+#define TRACE_REQUEST_SENT 4 // peer: neighbour rank
+#define TRACE_PUBLISHED 5 // peer: neighbour rank, value: temperature
+#define TRACE_REQUEST_SERVED 6 // peer: requesting rank, value: temperature
+#define TRACE_TEMPERATURE_RECEIVED 7 // peer: neighbour rank, value: temperature
+#define TRACE_TERMINATION 8
+#define TRACE_READ 9 // peer: neighbour rank
+
+
+// Define TraceHeader structure, written once at the start of a trace file
+typedef struct {
+	char magic[8];
+	int version;
+	int rank;
+} TraceHeader;
+
+// Define TraceEvent structure, a fixed-width record of one event
+typedef struct {
+	unsigned long long time; // nanoseconds of the monotonic clock
+	int type;
+	int peer;
+	long long value;
+} TraceEvent;
+
+// Define TraceBuffer structure, to store the events of a rank in memory until they are written out
+typedef struct {
+	TraceEvent* events;
+	int count;
+	FILE* fptr;
+} TraceBuffer;
+
+
+// Function definitions for trace.c
+void openTrace(TraceBuffer* trace, int rank);
+void flushTrace(TraceBuffer* trace);
+void closeTrace(TraceBuffer* trace);
+
+
+static inline void traceEvent(TraceBuffer* trace, int type, int peer, long long value) {
+	/**
+	 * Appends an event to the trace, writing the buffer out only when it is full
+	 */
+
+	struct timespec now;
+	TraceEvent* event;
+
+	if (trace->count == TRACE_BUFFER_EVENTS) flushTrace(trace);
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	event = &trace->events[trace->count++];
+	event->time = (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+	event->type = type;
+	event->peer = peer;
+	event->value = value;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "./trace.h"
+
+
+int main(int argc, char *argv[]) {
+	/**
+	 * Decodes a node's binary trace into the text log the node used to write
+	 */
+
+	if (argc != 2) {
+		printf("HELPER: tracedump <trace_rank.bin> > <log_rank.txt>\n");
+		return 1;
+	}
+
+	FILE* fptr = fopen(argv[1], "rb");
+	if (fptr == NULL) {
+		perror(argv[1]);
+		return 1;
+	}
+
+	// Check the header of the trace
+	TraceHeader header;
+	if (fread(&header, sizeof(TraceHeader), 1, fptr) != 1 || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 || header.version != TRACE_VERSION) {
+		fprintf(stderr, "ERROR: %s is not a version %d trace\n", argv[1], TRACE_VERSION);
+		return 1;
+	}
+
+	int rank = header.rank;
+	TraceEvent event;
+	struct in_addr address;
+	char IPAddress[INET_ADDRSTRLEN];
+	unsigned long long mac;
+
+	// Print each event as its log line
+	while (fread(&event, sizeof(TraceEvent), 1, fptr) == 1) {
+		switch (event.type) {
+			case TRACE_MAC_ADDRESS:
+				mac = event.value;
+				printf("MAC Address: %02X:%02X:%02X:%02X:%02X:%02X\n", (unsigned) (mac >> 40) & 0xFF, (unsigned) (mac >> 32) & 0xFF, 
+					(unsigned) (mac >> 24) & 0xFF, (unsigned) (mac >> 16) & 0xFF, (unsigned) (mac >> 8) & 0xFF, (unsigned) mac & 0xFF);
+				break;
+			case TRACE_IP_ADDRESS:
+				IPAddress[0] = '\0';
+				if (event.value >= 0) {
+					address.s_addr = (unsigned int) event.value;
+					inet_ntop(AF_INET, &address, IPAddress, sizeof(IPAddress));
+				}
+				printf("IP Address: %s\n", IPAddress);
+				break;
+			case TRACE_NEIGHBOUR:
+				printf("Neighbour Rank: %d, Coord: (%d, %d)\n", event.peer, (int) (event.value >> 32), (int) (event.value & 0xFFFFFFFF));
+				break;
+			case TRACE_TEMPERATURE:
+				printf("Temperature: %lld\n", event.value);
+				break;
+			case TRACE_REQUEST_SENT:
+				printf("Rank %d requesting temperature from neighbour rank %d\n", rank, event.peer);
+				printf("Rank %d awaiting for temperature from neighbour rank %d\n", rank, event.peer);
+				break;
+			case TRACE_READ:
+				printf("Rank %d reading the temperature of neighbour rank %d from its window\n", rank, event.peer);
+				break;
+			case TRACE_PUBLISHED:
+				printf("Rank %d published the temperature %lld to neighbour rank %d\n", rank, event.value, event.peer);
+				break;
+			case TRACE_REQUEST_SERVED:
+				printf("Rank %d has received request from %d and sent the temperature %lld to rank %d\n", rank, event.peer, event.value, event.peer);
+				break;
+			case TRACE_TEMPERATURE_RECEIVED:
+				printf("Rank %d has received the temperature %lld from rank %d\n", rank, event.value, event.peer);
+				break;
+			case TRACE_TERMINATION:
+				printf("Rank %d has received the termination signal\n", rank);
+				break;
+			default:
+				fprintf(stderr, "ERROR: unknown event type %d\n", event.type);
+				return 1;
+		}
+	}
+
+	fclose(fptr);
+	return 0;
+}